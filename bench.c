@@ -0,0 +1,80 @@
+#include "comp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define BENCH_MINIMUM_SECONDS 0.5
+
+/* Compresses a file at every deflate level and reports the compressed size
+   and the compression and inflate throughput, to pick a level from. */
+
+int main (int argc, char* argv[]) {
+
+	/* get command line parameters */
+	const char* fn;
+	if (argc > 2) {
+		printf ("usage: %s [file]\n", argv[0]);
+		exit (EXIT_FAILURE);
+	}
+	fn = (argc == 2) ? argv[1] : "content.xml";
+
+	/* read the whole file into memory */
+	FILE* fp;
+	long size;
+	unsigned char *src, *comp, *check;
+	fp = fopen (fn, "rb");
+	if (!fp || fseek (fp, 0, SEEK_END) || (size = ftell (fp)) < 0) {
+		printf ("could not open %s\n", fn);
+		exit (EXIT_FAILURE);
+	}
+	rewind (fp);
+	src = malloc (size + 1);
+	comp = malloc (comp_deflate_bound (size));
+	check = malloc (size + 1);
+	if (!src || !comp || !check)
+		printf ("memory allocation failure\n"), exit (EXIT_FAILURE);
+	if (size != fread (src, 1, size, fp)) {
+		printf ("could not read %s\n", fn);
+		exit (EXIT_FAILURE);
+	}
+	fclose (fp);
+
+	printf ("%s: %ld bytes\n", fn, size);
+	printf ("level   compressed   ratio   deflate MB/s   inflate MB/s\n");
+	for (int level = COMP_DEFLATE_STORED; level <= COMP_DEFLATE_BEST; level++) {
+
+		/* repeat each side until it has run long enough to time */
+		clock_t start;
+		double deflate_seconds, inflate_seconds;
+		long deflate_runs, inflate_runs;
+		int comp_size;
+		deflate_runs = 0;
+		start = clock ();
+		do {
+			comp_size = comp_deflate (comp, comp_deflate_bound (size), src, size, level);
+			deflate_runs++;
+			deflate_seconds = (double) (clock () - start) / CLOCKS_PER_SEC;
+		} while (deflate_seconds < BENCH_MINIMUM_SECONDS);
+
+		inflate_runs = 0;
+		start = clock ();
+		do {
+			if (size != comp_inflate (check, size, comp, comp_size) || memcmp (check, src, size)) {
+				printf ("level %d did not round trip\n", level);
+				exit (EXIT_FAILURE);
+			}
+			inflate_runs++;
+			inflate_seconds = (double) (clock () - start) / CLOCKS_PER_SEC;
+		} while (inflate_seconds < BENCH_MINIMUM_SECONDS);
+
+		printf ("%5d %12d %7.3f %14.1f %14.1f\n", level, comp_size,
+			size ? (double) comp_size / size : 0.0,
+			size * deflate_runs / deflate_seconds / 1e6,
+			size * inflate_runs / inflate_seconds / 1e6);
+	}
+
+	free (src);
+	free (comp);
+	free (check);
+	return 0;
+}
@@ -1,36 +1,577 @@
 #include "comp.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <limits.h>
+#if defined (__GNUC__) && defined (__x86_64__)
+#define COMP_HAVE_PCLMUL
+#include <immintrin.h>
+#endif
 
+typedef unsigned long long int u64;
 typedef unsigned long int u32;
 typedef unsigned short int u16;
 typedef unsigned char u8;
 
-typedef struct key_value_pair pair;
-struct key_value_pair {
-	u32 key;
-	u16 value;
+/* A Huffman decoding table is indexed by the next root_bits bits of the
+   stream (in stream order, i.e. with the code bits reversed). Codes no longer
+   than root_bits are replicated across every index they prefix and decode in
+   one probe; longer codes place a sub-table link in the primary table which
+   is indexed by the remaining bits of the code. */
+typedef struct huffman_table_entry table_entry;
+struct huffman_table_entry {
+	u8 op;		/* one of the HUFFMAN_OP_ values below */
+	u8 bits;	/* code bits consumed, or index width of a sub-table */
+	u16 value;	/* decoded symbol, or offset of a sub-table */
+};
+#define HUFFMAN_OP_SYMBOL 0
+#define HUFFMAN_OP_SUBTABLE 1
+#define HUFFMAN_OP_INVALID 2
+
+#define LITERAL_LENGTH_ROOT_BITS 9
+#define DISTANCE_ROOT_BITS 6
+#define CODE_LENGTH_ROOT_BITS 7
+#define MAX_CODE_LENGTH 15
+/* worst case primary + sub-table sizes for complete codes (see zlib's enough.c) */
+#define LITERAL_LENGTH_TABLE_SIZE 852
+#define DISTANCE_TABLE_SIZE 592
+#define CODE_LENGTH_TABLE_SIZE (1 << CODE_LENGTH_ROOT_BITS)
+
+/* The bit reader keeps the next unread bits of the stream in a 64-bit
+   accumulator, least significant bit first, and refills it a word at a time
+   from the current input chunk. Past the end of the last chunk it reads zero
+   bytes; bits_overrun() reports whether any of them have been consumed. */
+typedef struct comp_bit_reader bit_reader;
+struct comp_bit_reader {
+	const u8* src;
+	u32 src_size;
+	u32 index;	/* next byte of src to load into the accumulator */
+	u64 buffer;	/* pending bits, next bit in bit 0 */
+	int count;	/* number of pending bits */
+	int final;	/* src is the last chunk */
 };
+#define BIT_READER_MAX_PEEK 56
+
+void bits_init (bit_reader*);
+void bits_feed (bit_reader*, const u8*, u32, int);	/* chunk, size, last chunk */
+void bits_refill (bit_reader*);
+int bits_have (bit_reader*, int);			/* refill, then check the count */
+u32 bits_peek (const bit_reader*, int);		/* needs a refill first */
+void bits_consume (bit_reader*, int);
+u32 bits_get (bit_reader*, int);			/* refill, peek and consume */
+void bits_align (bit_reader*);
+int bits_overrun (const bit_reader*);
+u32 bits_copy_bytes (bit_reader*, u8*, u32);	/* must be byte aligned */
+int build_decode_table (table_entry*, int, int, const u8*, int);
+/* table, table size, root bits, code lengths, number of symbols */
+int peek_symbol (const table_entry*, int, bit_reader*, int*);
+/* table, root bits, bit reader, code length of the symbol found */
+#define DECODE_INVALID -1
+#define DECODE_NEED_INPUT -2
+void copy_match (u8*, u32, u32);
+/* output position, distance back, length */
+u32 reverse_bits (u32, int);
 
-int get_data_element (const u8*, u32*, int*, int);
-int get_bit (const u8*, u32*, int*);
-/* src, byte, bit within byte, # of bits to extract */
-void initialize_pair_array (pair*, int);
-int pair_cmp (const void*, const void*);
-int key_cmp (const void*, const void*);
+/* The bit writer collects output bits in a 64-bit accumulator, least
+   significant bit first, and stores them four bytes at a time. Stores past
+   dest_size are dropped but still counted in index. */
+typedef struct comp_bit_writer bit_writer;
+struct comp_bit_writer {
+	u8* dest;
+	u32 dest_size;
+	u32 index;	/* next byte of dest to store */
+	u64 buffer;	/* pending bits, first bit in bit 0 */
+	int count;	/* number of pending bits, always below 32 between calls */
+};
 
-const int LITERAL_LENGTH_TREE_SIZE = 288;
-const int DISTANCE_TREE_SIZE = 30;
+void bits_writer_init (bit_writer*, u8*, u32);
+void bits_put (bit_writer*, u32, int);		/* value, # of bits (at most 32) */
+void bits_flush (bit_writer*);				/* store pending bits, pad to a byte */
+
+#define LITERAL_LENGTH_TREE_SIZE 288
+#define DISTANCE_TREE_SIZE 32
 #define CODE_LENGTH_TREE_SIZE 19
+#define END_OF_BLOCK 256
 #define MIN_LENGTH_CODE 257
 #define MAX_LENGTH_CODE 285
 #define MAX_DISTANCE_CODE 29
 
+/* Decoding tables for the fixed Huffman codes on page 11 of the Spec., as
+   build_decode_table() lays them out: literal/length codes are 7 to 9 bits
+   and distance codes 5 bits, so neither needs sub-tables. The unused
+   literal/length codes 286-287 and distance codes 30-31 decode as invalid. */
+#define FIXED_LITERAL_LENGTH_TABLE_SIZE (1 << LITERAL_LENGTH_ROOT_BITS)
+#define FIXED_DISTANCE_TABLE_SIZE (1 << DISTANCE_ROOT_BITS)
+static const table_entry FIXED_LITERAL_LENGTH_TABLE[FIXED_LITERAL_LENGTH_TABLE_SIZE] = {
+	{0,7,256}, {0,8,80}, {0,8,16}, {0,8,280}, {0,7,272}, {0,8,112}, {0,8,48}, {0,9,192},
+	{0,7,264}, {0,8,96}, {0,8,32}, {0,9,160}, {0,8,0}, {0,8,128}, {0,8,64}, {0,9,224},
+	{0,7,260}, {0,8,88}, {0,8,24}, {0,9,144}, {0,7,276}, {0,8,120}, {0,8,56}, {0,9,208},
+	{0,7,268}, {0,8,104}, {0,8,40}, {0,9,176}, {0,8,8}, {0,8,136}, {0,8,72}, {0,9,240},
+	{0,7,258}, {0,8,84}, {0,8,20}, {0,8,284}, {0,7,274}, {0,8,116}, {0,8,52}, {0,9,200},
+	{0,7,266}, {0,8,100}, {0,8,36}, {0,9,168}, {0,8,4}, {0,8,132}, {0,8,68}, {0,9,232},
+	{0,7,262}, {0,8,92}, {0,8,28}, {0,9,152}, {0,7,278}, {0,8,124}, {0,8,60}, {0,9,216},
+	{0,7,270}, {0,8,108}, {0,8,44}, {0,9,184}, {0,8,12}, {0,8,140}, {0,8,76}, {0,9,248},
+	{0,7,257}, {0,8,82}, {0,8,18}, {0,8,282}, {0,7,273}, {0,8,114}, {0,8,50}, {0,9,196},
+	{0,7,265}, {0,8,98}, {0,8,34}, {0,9,164}, {0,8,2}, {0,8,130}, {0,8,66}, {0,9,228},
+	{0,7,261}, {0,8,90}, {0,8,26}, {0,9,148}, {0,7,277}, {0,8,122}, {0,8,58}, {0,9,212},
+	{0,7,269}, {0,8,106}, {0,8,42}, {0,9,180}, {0,8,10}, {0,8,138}, {0,8,74}, {0,9,244},
+	{0,7,259}, {0,8,86}, {0,8,22}, {2,8,0}, {0,7,275}, {0,8,118}, {0,8,54}, {0,9,204},
+	{0,7,267}, {0,8,102}, {0,8,38}, {0,9,172}, {0,8,6}, {0,8,134}, {0,8,70}, {0,9,236},
+	{0,7,263}, {0,8,94}, {0,8,30}, {0,9,156}, {0,7,279}, {0,8,126}, {0,8,62}, {0,9,220},
+	{0,7,271}, {0,8,110}, {0,8,46}, {0,9,188}, {0,8,14}, {0,8,142}, {0,8,78}, {0,9,252},
+	{0,7,256}, {0,8,81}, {0,8,17}, {0,8,281}, {0,7,272}, {0,8,113}, {0,8,49}, {0,9,194},
+	{0,7,264}, {0,8,97}, {0,8,33}, {0,9,162}, {0,8,1}, {0,8,129}, {0,8,65}, {0,9,226},
+	{0,7,260}, {0,8,89}, {0,8,25}, {0,9,146}, {0,7,276}, {0,8,121}, {0,8,57}, {0,9,210},
+	{0,7,268}, {0,8,105}, {0,8,41}, {0,9,178}, {0,8,9}, {0,8,137}, {0,8,73}, {0,9,242},
+	{0,7,258}, {0,8,85}, {0,8,21}, {0,8,285}, {0,7,274}, {0,8,117}, {0,8,53}, {0,9,202},
+	{0,7,266}, {0,8,101}, {0,8,37}, {0,9,170}, {0,8,5}, {0,8,133}, {0,8,69}, {0,9,234},
+	{0,7,262}, {0,8,93}, {0,8,29}, {0,9,154}, {0,7,278}, {0,8,125}, {0,8,61}, {0,9,218},
+	{0,7,270}, {0,8,109}, {0,8,45}, {0,9,186}, {0,8,13}, {0,8,141}, {0,8,77}, {0,9,250},
+	{0,7,257}, {0,8,83}, {0,8,19}, {0,8,283}, {0,7,273}, {0,8,115}, {0,8,51}, {0,9,198},
+	{0,7,265}, {0,8,99}, {0,8,35}, {0,9,166}, {0,8,3}, {0,8,131}, {0,8,67}, {0,9,230},
+	{0,7,261}, {0,8,91}, {0,8,27}, {0,9,150}, {0,7,277}, {0,8,123}, {0,8,59}, {0,9,214},
+	{0,7,269}, {0,8,107}, {0,8,43}, {0,9,182}, {0,8,11}, {0,8,139}, {0,8,75}, {0,9,246},
+	{0,7,259}, {0,8,87}, {0,8,23}, {2,8,0}, {0,7,275}, {0,8,119}, {0,8,55}, {0,9,206},
+	{0,7,267}, {0,8,103}, {0,8,39}, {0,9,174}, {0,8,7}, {0,8,135}, {0,8,71}, {0,9,238},
+	{0,7,263}, {0,8,95}, {0,8,31}, {0,9,158}, {0,7,279}, {0,8,127}, {0,8,63}, {0,9,222},
+	{0,7,271}, {0,8,111}, {0,8,47}, {0,9,190}, {0,8,15}, {0,8,143}, {0,8,79}, {0,9,254},
+	{0,7,256}, {0,8,80}, {0,8,16}, {0,8,280}, {0,7,272}, {0,8,112}, {0,8,48}, {0,9,193},
+	{0,7,264}, {0,8,96}, {0,8,32}, {0,9,161}, {0,8,0}, {0,8,128}, {0,8,64}, {0,9,225},
+	{0,7,260}, {0,8,88}, {0,8,24}, {0,9,145}, {0,7,276}, {0,8,120}, {0,8,56}, {0,9,209},
+	{0,7,268}, {0,8,104}, {0,8,40}, {0,9,177}, {0,8,8}, {0,8,136}, {0,8,72}, {0,9,241},
+	{0,7,258}, {0,8,84}, {0,8,20}, {0,8,284}, {0,7,274}, {0,8,116}, {0,8,52}, {0,9,201},
+	{0,7,266}, {0,8,100}, {0,8,36}, {0,9,169}, {0,8,4}, {0,8,132}, {0,8,68}, {0,9,233},
+	{0,7,262}, {0,8,92}, {0,8,28}, {0,9,153}, {0,7,278}, {0,8,124}, {0,8,60}, {0,9,217},
+	{0,7,270}, {0,8,108}, {0,8,44}, {0,9,185}, {0,8,12}, {0,8,140}, {0,8,76}, {0,9,249},
+	{0,7,257}, {0,8,82}, {0,8,18}, {0,8,282}, {0,7,273}, {0,8,114}, {0,8,50}, {0,9,197},
+	{0,7,265}, {0,8,98}, {0,8,34}, {0,9,165}, {0,8,2}, {0,8,130}, {0,8,66}, {0,9,229},
+	{0,7,261}, {0,8,90}, {0,8,26}, {0,9,149}, {0,7,277}, {0,8,122}, {0,8,58}, {0,9,213},
+	{0,7,269}, {0,8,106}, {0,8,42}, {0,9,181}, {0,8,10}, {0,8,138}, {0,8,74}, {0,9,245},
+	{0,7,259}, {0,8,86}, {0,8,22}, {2,8,0}, {0,7,275}, {0,8,118}, {0,8,54}, {0,9,205},
+	{0,7,267}, {0,8,102}, {0,8,38}, {0,9,173}, {0,8,6}, {0,8,134}, {0,8,70}, {0,9,237},
+	{0,7,263}, {0,8,94}, {0,8,30}, {0,9,157}, {0,7,279}, {0,8,126}, {0,8,62}, {0,9,221},
+	{0,7,271}, {0,8,110}, {0,8,46}, {0,9,189}, {0,8,14}, {0,8,142}, {0,8,78}, {0,9,253},
+	{0,7,256}, {0,8,81}, {0,8,17}, {0,8,281}, {0,7,272}, {0,8,113}, {0,8,49}, {0,9,195},
+	{0,7,264}, {0,8,97}, {0,8,33}, {0,9,163}, {0,8,1}, {0,8,129}, {0,8,65}, {0,9,227},
+	{0,7,260}, {0,8,89}, {0,8,25}, {0,9,147}, {0,7,276}, {0,8,121}, {0,8,57}, {0,9,211},
+	{0,7,268}, {0,8,105}, {0,8,41}, {0,9,179}, {0,8,9}, {0,8,137}, {0,8,73}, {0,9,243},
+	{0,7,258}, {0,8,85}, {0,8,21}, {0,8,285}, {0,7,274}, {0,8,117}, {0,8,53}, {0,9,203},
+	{0,7,266}, {0,8,101}, {0,8,37}, {0,9,171}, {0,8,5}, {0,8,133}, {0,8,69}, {0,9,235},
+	{0,7,262}, {0,8,93}, {0,8,29}, {0,9,155}, {0,7,278}, {0,8,125}, {0,8,61}, {0,9,219},
+	{0,7,270}, {0,8,109}, {0,8,45}, {0,9,187}, {0,8,13}, {0,8,141}, {0,8,77}, {0,9,251},
+	{0,7,257}, {0,8,83}, {0,8,19}, {0,8,283}, {0,7,273}, {0,8,115}, {0,8,51}, {0,9,199},
+	{0,7,265}, {0,8,99}, {0,8,35}, {0,9,167}, {0,8,3}, {0,8,131}, {0,8,67}, {0,9,231},
+	{0,7,261}, {0,8,91}, {0,8,27}, {0,9,151}, {0,7,277}, {0,8,123}, {0,8,59}, {0,9,215},
+	{0,7,269}, {0,8,107}, {0,8,43}, {0,9,183}, {0,8,11}, {0,8,139}, {0,8,75}, {0,9,247},
+	{0,7,259}, {0,8,87}, {0,8,23}, {2,8,0}, {0,7,275}, {0,8,119}, {0,8,55}, {0,9,207},
+	{0,7,267}, {0,8,103}, {0,8,39}, {0,9,175}, {0,8,7}, {0,8,135}, {0,8,71}, {0,9,239},
+	{0,7,263}, {0,8,95}, {0,8,31}, {0,9,159}, {0,7,279}, {0,8,127}, {0,8,63}, {0,9,223},
+	{0,7,271}, {0,8,111}, {0,8,47}, {0,9,191}, {0,8,15}, {0,8,143}, {0,8,79}, {0,9,255}
+};
+static const table_entry FIXED_DISTANCE_TABLE[FIXED_DISTANCE_TABLE_SIZE] = {
+	{0,5,0}, {0,5,16}, {0,5,8}, {0,5,24}, {0,5,4}, {0,5,20}, {0,5,12}, {0,5,28},
+	{0,5,2}, {0,5,18}, {0,5,10}, {0,5,26}, {0,5,6}, {0,5,22}, {0,5,14}, {2,5,0},
+	{0,5,1}, {0,5,17}, {0,5,9}, {0,5,25}, {0,5,5}, {0,5,21}, {0,5,13}, {0,5,29},
+	{0,5,3}, {0,5,19}, {0,5,11}, {0,5,27}, {0,5,7}, {0,5,23}, {0,5,15}, {2,5,0},
+	{0,5,0}, {0,5,16}, {0,5,8}, {0,5,24}, {0,5,4}, {0,5,20}, {0,5,12}, {0,5,28},
+	{0,5,2}, {0,5,18}, {0,5,10}, {0,5,26}, {0,5,6}, {0,5,22}, {0,5,14}, {2,5,0},
+	{0,5,1}, {0,5,17}, {0,5,9}, {0,5,25}, {0,5,5}, {0,5,21}, {0,5,13}, {0,5,29},
+	{0,5,3}, {0,5,19}, {0,5,11}, {0,5,27}, {0,5,7}, {0,5,23}, {0,5,15}, {2,5,0}
+};
+
+/* the length and distance code extra bit tables from page 11 of the Deflate spec. */
+static const u16 LENGTH_BASE[MAX_LENGTH_CODE - MIN_LENGTH_CODE + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const u8 LENGTH_EXTRA_BITS[MAX_LENGTH_CODE - MIN_LENGTH_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const u16 DISTANCE_BASE[MAX_DISTANCE_CODE + 1] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+	513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const u8 DISTANCE_EXTRA_BITS[MAX_DISTANCE_CODE + 1] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* CRC-32 remainders for the reflected polynomial 0xedb88320. Row 0 is the
+   remainder of each byte value; row k is the remainder of that byte followed
+   by k zero bytes, so eight rows together advance the CRC eight bytes. */
+static const u32 CRC32_TABLE[8][256] = {
+	{
+		0x00000000UL, 0x77073096UL, 0xee0e612cUL, 0x990951baUL, 0x076dc419UL, 0x706af48fUL,
+		0xe963a535UL, 0x9e6495a3UL, 0x0edb8832UL, 0x79dcb8a4UL, 0xe0d5e91eUL, 0x97d2d988UL,
+		0x09b64c2bUL, 0x7eb17cbdUL, 0xe7b82d07UL, 0x90bf1d91UL, 0x1db71064UL, 0x6ab020f2UL,
+		0xf3b97148UL, 0x84be41deUL, 0x1adad47dUL, 0x6ddde4ebUL, 0xf4d4b551UL, 0x83d385c7UL,
+		0x136c9856UL, 0x646ba8c0UL, 0xfd62f97aUL, 0x8a65c9ecUL, 0x14015c4fUL, 0x63066cd9UL,
+		0xfa0f3d63UL, 0x8d080df5UL, 0x3b6e20c8UL, 0x4c69105eUL, 0xd56041e4UL, 0xa2677172UL,
+		0x3c03e4d1UL, 0x4b04d447UL, 0xd20d85fdUL, 0xa50ab56bUL, 0x35b5a8faUL, 0x42b2986cUL,
+		0xdbbbc9d6UL, 0xacbcf940UL, 0x32d86ce3UL, 0x45df5c75UL, 0xdcd60dcfUL, 0xabd13d59UL,
+		0x26d930acUL, 0x51de003aUL, 0xc8d75180UL, 0xbfd06116UL, 0x21b4f4b5UL, 0x56b3c423UL,
+		0xcfba9599UL, 0xb8bda50fUL, 0x2802b89eUL, 0x5f058808UL, 0xc60cd9b2UL, 0xb10be924UL,
+		0x2f6f7c87UL, 0x58684c11UL, 0xc1611dabUL, 0xb6662d3dUL, 0x76dc4190UL, 0x01db7106UL,
+		0x98d220bcUL, 0xefd5102aUL, 0x71b18589UL, 0x06b6b51fUL, 0x9fbfe4a5UL, 0xe8b8d433UL,
+		0x7807c9a2UL, 0x0f00f934UL, 0x9609a88eUL, 0xe10e9818UL, 0x7f6a0dbbUL, 0x086d3d2dUL,
+		0x91646c97UL, 0xe6635c01UL, 0x6b6b51f4UL, 0x1c6c6162UL, 0x856530d8UL, 0xf262004eUL,
+		0x6c0695edUL, 0x1b01a57bUL, 0x8208f4c1UL, 0xf50fc457UL, 0x65b0d9c6UL, 0x12b7e950UL,
+		0x8bbeb8eaUL, 0xfcb9887cUL, 0x62dd1ddfUL, 0x15da2d49UL, 0x8cd37cf3UL, 0xfbd44c65UL,
+		0x4db26158UL, 0x3ab551ceUL, 0xa3bc0074UL, 0xd4bb30e2UL, 0x4adfa541UL, 0x3dd895d7UL,
+		0xa4d1c46dUL, 0xd3d6f4fbUL, 0x4369e96aUL, 0x346ed9fcUL, 0xad678846UL, 0xda60b8d0UL,
+		0x44042d73UL, 0x33031de5UL, 0xaa0a4c5fUL, 0xdd0d7cc9UL, 0x5005713cUL, 0x270241aaUL,
+		0xbe0b1010UL, 0xc90c2086UL, 0x5768b525UL, 0x206f85b3UL, 0xb966d409UL, 0xce61e49fUL,
+		0x5edef90eUL, 0x29d9c998UL, 0xb0d09822UL, 0xc7d7a8b4UL, 0x59b33d17UL, 0x2eb40d81UL,
+		0xb7bd5c3bUL, 0xc0ba6cadUL, 0xedb88320UL, 0x9abfb3b6UL, 0x03b6e20cUL, 0x74b1d29aUL,
+		0xead54739UL, 0x9dd277afUL, 0x04db2615UL, 0x73dc1683UL, 0xe3630b12UL, 0x94643b84UL,
+		0x0d6d6a3eUL, 0x7a6a5aa8UL, 0xe40ecf0bUL, 0x9309ff9dUL, 0x0a00ae27UL, 0x7d079eb1UL,
+		0xf00f9344UL, 0x8708a3d2UL, 0x1e01f268UL, 0x6906c2feUL, 0xf762575dUL, 0x806567cbUL,
+		0x196c3671UL, 0x6e6b06e7UL, 0xfed41b76UL, 0x89d32be0UL, 0x10da7a5aUL, 0x67dd4accUL,
+		0xf9b9df6fUL, 0x8ebeeff9UL, 0x17b7be43UL, 0x60b08ed5UL, 0xd6d6a3e8UL, 0xa1d1937eUL,
+		0x38d8c2c4UL, 0x4fdff252UL, 0xd1bb67f1UL, 0xa6bc5767UL, 0x3fb506ddUL, 0x48b2364bUL,
+		0xd80d2bdaUL, 0xaf0a1b4cUL, 0x36034af6UL, 0x41047a60UL, 0xdf60efc3UL, 0xa867df55UL,
+		0x316e8eefUL, 0x4669be79UL, 0xcb61b38cUL, 0xbc66831aUL, 0x256fd2a0UL, 0x5268e236UL,
+		0xcc0c7795UL, 0xbb0b4703UL, 0x220216b9UL, 0x5505262fUL, 0xc5ba3bbeUL, 0xb2bd0b28UL,
+		0x2bb45a92UL, 0x5cb36a04UL, 0xc2d7ffa7UL, 0xb5d0cf31UL, 0x2cd99e8bUL, 0x5bdeae1dUL,
+		0x9b64c2b0UL, 0xec63f226UL, 0x756aa39cUL, 0x026d930aUL, 0x9c0906a9UL, 0xeb0e363fUL,
+		0x72076785UL, 0x05005713UL, 0x95bf4a82UL, 0xe2b87a14UL, 0x7bb12baeUL, 0x0cb61b38UL,
+		0x92d28e9bUL, 0xe5d5be0dUL, 0x7cdcefb7UL, 0x0bdbdf21UL, 0x86d3d2d4UL, 0xf1d4e242UL,
+		0x68ddb3f8UL, 0x1fda836eUL, 0x81be16cdUL, 0xf6b9265bUL, 0x6fb077e1UL, 0x18b74777UL,
+		0x88085ae6UL, 0xff0f6a70UL, 0x66063bcaUL, 0x11010b5cUL, 0x8f659effUL, 0xf862ae69UL,
+		0x616bffd3UL, 0x166ccf45UL, 0xa00ae278UL, 0xd70dd2eeUL, 0x4e048354UL, 0x3903b3c2UL,
+		0xa7672661UL, 0xd06016f7UL, 0x4969474dUL, 0x3e6e77dbUL, 0xaed16a4aUL, 0xd9d65adcUL,
+		0x40df0b66UL, 0x37d83bf0UL, 0xa9bcae53UL, 0xdebb9ec5UL, 0x47b2cf7fUL, 0x30b5ffe9UL,
+		0xbdbdf21cUL, 0xcabac28aUL, 0x53b39330UL, 0x24b4a3a6UL, 0xbad03605UL, 0xcdd70693UL,
+		0x54de5729UL, 0x23d967bfUL, 0xb3667a2eUL, 0xc4614ab8UL, 0x5d681b02UL, 0x2a6f2b94UL,
+		0xb40bbe37UL, 0xc30c8ea1UL, 0x5a05df1bUL, 0x2d02ef8dUL
+	},
+	{
+		0x00000000UL, 0x191b3141UL, 0x32366282UL, 0x2b2d53c3UL, 0x646cc504UL, 0x7d77f445UL,
+		0x565aa786UL, 0x4f4196c7UL, 0xc8d98a08UL, 0xd1c2bb49UL, 0xfaefe88aUL, 0xe3f4d9cbUL,
+		0xacb54f0cUL, 0xb5ae7e4dUL, 0x9e832d8eUL, 0x87981ccfUL, 0x4ac21251UL, 0x53d92310UL,
+		0x78f470d3UL, 0x61ef4192UL, 0x2eaed755UL, 0x37b5e614UL, 0x1c98b5d7UL, 0x05838496UL,
+		0x821b9859UL, 0x9b00a918UL, 0xb02dfadbUL, 0xa936cb9aUL, 0xe6775d5dUL, 0xff6c6c1cUL,
+		0xd4413fdfUL, 0xcd5a0e9eUL, 0x958424a2UL, 0x8c9f15e3UL, 0xa7b24620UL, 0xbea97761UL,
+		0xf1e8e1a6UL, 0xe8f3d0e7UL, 0xc3de8324UL, 0xdac5b265UL, 0x5d5daeaaUL, 0x44469febUL,
+		0x6f6bcc28UL, 0x7670fd69UL, 0x39316baeUL, 0x202a5aefUL, 0x0b07092cUL, 0x121c386dUL,
+		0xdf4636f3UL, 0xc65d07b2UL, 0xed705471UL, 0xf46b6530UL, 0xbb2af3f7UL, 0xa231c2b6UL,
+		0x891c9175UL, 0x9007a034UL, 0x179fbcfbUL, 0x0e848dbaUL, 0x25a9de79UL, 0x3cb2ef38UL,
+		0x73f379ffUL, 0x6ae848beUL, 0x41c51b7dUL, 0x58de2a3cUL, 0xf0794f05UL, 0xe9627e44UL,
+		0xc24f2d87UL, 0xdb541cc6UL, 0x94158a01UL, 0x8d0ebb40UL, 0xa623e883UL, 0xbf38d9c2UL,
+		0x38a0c50dUL, 0x21bbf44cUL, 0x0a96a78fUL, 0x138d96ceUL, 0x5ccc0009UL, 0x45d73148UL,
+		0x6efa628bUL, 0x77e153caUL, 0xbabb5d54UL, 0xa3a06c15UL, 0x888d3fd6UL, 0x91960e97UL,
+		0xded79850UL, 0xc7cca911UL, 0xece1fad2UL, 0xf5facb93UL, 0x7262d75cUL, 0x6b79e61dUL,
+		0x4054b5deUL, 0x594f849fUL, 0x160e1258UL, 0x0f152319UL, 0x243870daUL, 0x3d23419bUL,
+		0x65fd6ba7UL, 0x7ce65ae6UL, 0x57cb0925UL, 0x4ed03864UL, 0x0191aea3UL, 0x188a9fe2UL,
+		0x33a7cc21UL, 0x2abcfd60UL, 0xad24e1afUL, 0xb43fd0eeUL, 0x9f12832dUL, 0x8609b26cUL,
+		0xc94824abUL, 0xd05315eaUL, 0xfb7e4629UL, 0xe2657768UL, 0x2f3f79f6UL, 0x362448b7UL,
+		0x1d091b74UL, 0x04122a35UL, 0x4b53bcf2UL, 0x52488db3UL, 0x7965de70UL, 0x607eef31UL,
+		0xe7e6f3feUL, 0xfefdc2bfUL, 0xd5d0917cUL, 0xcccba03dUL, 0x838a36faUL, 0x9a9107bbUL,
+		0xb1bc5478UL, 0xa8a76539UL, 0x3b83984bUL, 0x2298a90aUL, 0x09b5fac9UL, 0x10aecb88UL,
+		0x5fef5d4fUL, 0x46f46c0eUL, 0x6dd93fcdUL, 0x74c20e8cUL, 0xf35a1243UL, 0xea412302UL,
+		0xc16c70c1UL, 0xd8774180UL, 0x9736d747UL, 0x8e2de606UL, 0xa500b5c5UL, 0xbc1b8484UL,
+		0x71418a1aUL, 0x685abb5bUL, 0x4377e898UL, 0x5a6cd9d9UL, 0x152d4f1eUL, 0x0c367e5fUL,
+		0x271b2d9cUL, 0x3e001cddUL, 0xb9980012UL, 0xa0833153UL, 0x8bae6290UL, 0x92b553d1UL,
+		0xddf4c516UL, 0xc4eff457UL, 0xefc2a794UL, 0xf6d996d5UL, 0xae07bce9UL, 0xb71c8da8UL,
+		0x9c31de6bUL, 0x852aef2aUL, 0xca6b79edUL, 0xd37048acUL, 0xf85d1b6fUL, 0xe1462a2eUL,
+		0x66de36e1UL, 0x7fc507a0UL, 0x54e85463UL, 0x4df36522UL, 0x02b2f3e5UL, 0x1ba9c2a4UL,
+		0x30849167UL, 0x299fa026UL, 0xe4c5aeb8UL, 0xfdde9ff9UL, 0xd6f3cc3aUL, 0xcfe8fd7bUL,
+		0x80a96bbcUL, 0x99b25afdUL, 0xb29f093eUL, 0xab84387fUL, 0x2c1c24b0UL, 0x350715f1UL,
+		0x1e2a4632UL, 0x07317773UL, 0x4870e1b4UL, 0x516bd0f5UL, 0x7a468336UL, 0x635db277UL,
+		0xcbfad74eUL, 0xd2e1e60fUL, 0xf9ccb5ccUL, 0xe0d7848dUL, 0xaf96124aUL, 0xb68d230bUL,
+		0x9da070c8UL, 0x84bb4189UL, 0x03235d46UL, 0x1a386c07UL, 0x31153fc4UL, 0x280e0e85UL,
+		0x674f9842UL, 0x7e54a903UL, 0x5579fac0UL, 0x4c62cb81UL, 0x8138c51fUL, 0x9823f45eUL,
+		0xb30ea79dUL, 0xaa1596dcUL, 0xe554001bUL, 0xfc4f315aUL, 0xd7626299UL, 0xce7953d8UL,
+		0x49e14f17UL, 0x50fa7e56UL, 0x7bd72d95UL, 0x62cc1cd4UL, 0x2d8d8a13UL, 0x3496bb52UL,
+		0x1fbbe891UL, 0x06a0d9d0UL, 0x5e7ef3ecUL, 0x4765c2adUL, 0x6c48916eUL, 0x7553a02fUL,
+		0x3a1236e8UL, 0x230907a9UL, 0x0824546aUL, 0x113f652bUL, 0x96a779e4UL, 0x8fbc48a5UL,
+		0xa4911b66UL, 0xbd8a2a27UL, 0xf2cbbce0UL, 0xebd08da1UL, 0xc0fdde62UL, 0xd9e6ef23UL,
+		0x14bce1bdUL, 0x0da7d0fcUL, 0x268a833fUL, 0x3f91b27eUL, 0x70d024b9UL, 0x69cb15f8UL,
+		0x42e6463bUL, 0x5bfd777aUL, 0xdc656bb5UL, 0xc57e5af4UL, 0xee530937UL, 0xf7483876UL,
+		0xb809aeb1UL, 0xa1129ff0UL, 0x8a3fcc33UL, 0x9324fd72UL
+	},
+	{
+		0x00000000UL, 0x01c26a37UL, 0x0384d46eUL, 0x0246be59UL, 0x0709a8dcUL, 0x06cbc2ebUL,
+		0x048d7cb2UL, 0x054f1685UL, 0x0e1351b8UL, 0x0fd13b8fUL, 0x0d9785d6UL, 0x0c55efe1UL,
+		0x091af964UL, 0x08d89353UL, 0x0a9e2d0aUL, 0x0b5c473dUL, 0x1c26a370UL, 0x1de4c947UL,
+		0x1fa2771eUL, 0x1e601d29UL, 0x1b2f0bacUL, 0x1aed619bUL, 0x18abdfc2UL, 0x1969b5f5UL,
+		0x1235f2c8UL, 0x13f798ffUL, 0x11b126a6UL, 0x10734c91UL, 0x153c5a14UL, 0x14fe3023UL,
+		0x16b88e7aUL, 0x177ae44dUL, 0x384d46e0UL, 0x398f2cd7UL, 0x3bc9928eUL, 0x3a0bf8b9UL,
+		0x3f44ee3cUL, 0x3e86840bUL, 0x3cc03a52UL, 0x3d025065UL, 0x365e1758UL, 0x379c7d6fUL,
+		0x35dac336UL, 0x3418a901UL, 0x3157bf84UL, 0x3095d5b3UL, 0x32d36beaUL, 0x331101ddUL,
+		0x246be590UL, 0x25a98fa7UL, 0x27ef31feUL, 0x262d5bc9UL, 0x23624d4cUL, 0x22a0277bUL,
+		0x20e69922UL, 0x2124f315UL, 0x2a78b428UL, 0x2bbade1fUL, 0x29fc6046UL, 0x283e0a71UL,
+		0x2d711cf4UL, 0x2cb376c3UL, 0x2ef5c89aUL, 0x2f37a2adUL, 0x709a8dc0UL, 0x7158e7f7UL,
+		0x731e59aeUL, 0x72dc3399UL, 0x7793251cUL, 0x76514f2bUL, 0x7417f172UL, 0x75d59b45UL,
+		0x7e89dc78UL, 0x7f4bb64fUL, 0x7d0d0816UL, 0x7ccf6221UL, 0x798074a4UL, 0x78421e93UL,
+		0x7a04a0caUL, 0x7bc6cafdUL, 0x6cbc2eb0UL, 0x6d7e4487UL, 0x6f38fadeUL, 0x6efa90e9UL,
+		0x6bb5866cUL, 0x6a77ec5bUL, 0x68315202UL, 0x69f33835UL, 0x62af7f08UL, 0x636d153fUL,
+		0x612bab66UL, 0x60e9c151UL, 0x65a6d7d4UL, 0x6464bde3UL, 0x662203baUL, 0x67e0698dUL,
+		0x48d7cb20UL, 0x4915a117UL, 0x4b531f4eUL, 0x4a917579UL, 0x4fde63fcUL, 0x4e1c09cbUL,
+		0x4c5ab792UL, 0x4d98dda5UL, 0x46c49a98UL, 0x4706f0afUL, 0x45404ef6UL, 0x448224c1UL,
+		0x41cd3244UL, 0x400f5873UL, 0x4249e62aUL, 0x438b8c1dUL, 0x54f16850UL, 0x55330267UL,
+		0x5775bc3eUL, 0x56b7d609UL, 0x53f8c08cUL, 0x523aaabbUL, 0x507c14e2UL, 0x51be7ed5UL,
+		0x5ae239e8UL, 0x5b2053dfUL, 0x5966ed86UL, 0x58a487b1UL, 0x5deb9134UL, 0x5c29fb03UL,
+		0x5e6f455aUL, 0x5fad2f6dUL, 0xe1351b80UL, 0xe0f771b7UL, 0xe2b1cfeeUL, 0xe373a5d9UL,
+		0xe63cb35cUL, 0xe7fed96bUL, 0xe5b86732UL, 0xe47a0d05UL, 0xef264a38UL, 0xeee4200fUL,
+		0xeca29e56UL, 0xed60f461UL, 0xe82fe2e4UL, 0xe9ed88d3UL, 0xebab368aUL, 0xea695cbdUL,
+		0xfd13b8f0UL, 0xfcd1d2c7UL, 0xfe976c9eUL, 0xff5506a9UL, 0xfa1a102cUL, 0xfbd87a1bUL,
+		0xf99ec442UL, 0xf85cae75UL, 0xf300e948UL, 0xf2c2837fUL, 0xf0843d26UL, 0xf1465711UL,
+		0xf4094194UL, 0xf5cb2ba3UL, 0xf78d95faUL, 0xf64fffcdUL, 0xd9785d60UL, 0xd8ba3757UL,
+		0xdafc890eUL, 0xdb3ee339UL, 0xde71f5bcUL, 0xdfb39f8bUL, 0xddf521d2UL, 0xdc374be5UL,
+		0xd76b0cd8UL, 0xd6a966efUL, 0xd4efd8b6UL, 0xd52db281UL, 0xd062a404UL, 0xd1a0ce33UL,
+		0xd3e6706aUL, 0xd2241a5dUL, 0xc55efe10UL, 0xc49c9427UL, 0xc6da2a7eUL, 0xc7184049UL,
+		0xc25756ccUL, 0xc3953cfbUL, 0xc1d382a2UL, 0xc011e895UL, 0xcb4dafa8UL, 0xca8fc59fUL,
+		0xc8c97bc6UL, 0xc90b11f1UL, 0xcc440774UL, 0xcd866d43UL, 0xcfc0d31aUL, 0xce02b92dUL,
+		0x91af9640UL, 0x906dfc77UL, 0x922b422eUL, 0x93e92819UL, 0x96a63e9cUL, 0x976454abUL,
+		0x9522eaf2UL, 0x94e080c5UL, 0x9fbcc7f8UL, 0x9e7eadcfUL, 0x9c381396UL, 0x9dfa79a1UL,
+		0x98b56f24UL, 0x99770513UL, 0x9b31bb4aUL, 0x9af3d17dUL, 0x8d893530UL, 0x8c4b5f07UL,
+		0x8e0de15eUL, 0x8fcf8b69UL, 0x8a809decUL, 0x8b42f7dbUL, 0x89044982UL, 0x88c623b5UL,
+		0x839a6488UL, 0x82580ebfUL, 0x801eb0e6UL, 0x81dcdad1UL, 0x8493cc54UL, 0x8551a663UL,
+		0x8717183aUL, 0x86d5720dUL, 0xa9e2d0a0UL, 0xa820ba97UL, 0xaa6604ceUL, 0xaba46ef9UL,
+		0xaeeb787cUL, 0xaf29124bUL, 0xad6fac12UL, 0xacadc625UL, 0xa7f18118UL, 0xa633eb2fUL,
+		0xa4755576UL, 0xa5b73f41UL, 0xa0f829c4UL, 0xa13a43f3UL, 0xa37cfdaaUL, 0xa2be979dUL,
+		0xb5c473d0UL, 0xb40619e7UL, 0xb640a7beUL, 0xb782cd89UL, 0xb2cddb0cUL, 0xb30fb13bUL,
+		0xb1490f62UL, 0xb08b6555UL, 0xbbd72268UL, 0xba15485fUL, 0xb853f606UL, 0xb9919c31UL,
+		0xbcde8ab4UL, 0xbd1ce083UL, 0xbf5a5edaUL, 0xbe9834edUL
+	},
+	{
+		0x00000000UL, 0xb8bc6765UL, 0xaa09c88bUL, 0x12b5afeeUL, 0x8f629757UL, 0x37def032UL,
+		0x256b5fdcUL, 0x9dd738b9UL, 0xc5b428efUL, 0x7d084f8aUL, 0x6fbde064UL, 0xd7018701UL,
+		0x4ad6bfb8UL, 0xf26ad8ddUL, 0xe0df7733UL, 0x58631056UL, 0x5019579fUL, 0xe8a530faUL,
+		0xfa109f14UL, 0x42acf871UL, 0xdf7bc0c8UL, 0x67c7a7adUL, 0x75720843UL, 0xcdce6f26UL,
+		0x95ad7f70UL, 0x2d111815UL, 0x3fa4b7fbUL, 0x8718d09eUL, 0x1acfe827UL, 0xa2738f42UL,
+		0xb0c620acUL, 0x087a47c9UL, 0xa032af3eUL, 0x188ec85bUL, 0x0a3b67b5UL, 0xb28700d0UL,
+		0x2f503869UL, 0x97ec5f0cUL, 0x8559f0e2UL, 0x3de59787UL, 0x658687d1UL, 0xdd3ae0b4UL,
+		0xcf8f4f5aUL, 0x7733283fUL, 0xeae41086UL, 0x525877e3UL, 0x40edd80dUL, 0xf851bf68UL,
+		0xf02bf8a1UL, 0x48979fc4UL, 0x5a22302aUL, 0xe29e574fUL, 0x7f496ff6UL, 0xc7f50893UL,
+		0xd540a77dUL, 0x6dfcc018UL, 0x359fd04eUL, 0x8d23b72bUL, 0x9f9618c5UL, 0x272a7fa0UL,
+		0xbafd4719UL, 0x0241207cUL, 0x10f48f92UL, 0xa848e8f7UL, 0x9b14583dUL, 0x23a83f58UL,
+		0x311d90b6UL, 0x89a1f7d3UL, 0x1476cf6aUL, 0xaccaa80fUL, 0xbe7f07e1UL, 0x06c36084UL,
+		0x5ea070d2UL, 0xe61c17b7UL, 0xf4a9b859UL, 0x4c15df3cUL, 0xd1c2e785UL, 0x697e80e0UL,
+		0x7bcb2f0eUL, 0xc377486bUL, 0xcb0d0fa2UL, 0x73b168c7UL, 0x6104c729UL, 0xd9b8a04cUL,
+		0x446f98f5UL, 0xfcd3ff90UL, 0xee66507eUL, 0x56da371bUL, 0x0eb9274dUL, 0xb6054028UL,
+		0xa4b0efc6UL, 0x1c0c88a3UL, 0x81dbb01aUL, 0x3967d77fUL, 0x2bd27891UL, 0x936e1ff4UL,
+		0x3b26f703UL, 0x839a9066UL, 0x912f3f88UL, 0x299358edUL, 0xb4446054UL, 0x0cf80731UL,
+		0x1e4da8dfUL, 0xa6f1cfbaUL, 0xfe92dfecUL, 0x462eb889UL, 0x549b1767UL, 0xec277002UL,
+		0x71f048bbUL, 0xc94c2fdeUL, 0xdbf98030UL, 0x6345e755UL, 0x6b3fa09cUL, 0xd383c7f9UL,
+		0xc1366817UL, 0x798a0f72UL, 0xe45d37cbUL, 0x5ce150aeUL, 0x4e54ff40UL, 0xf6e89825UL,
+		0xae8b8873UL, 0x1637ef16UL, 0x048240f8UL, 0xbc3e279dUL, 0x21e91f24UL, 0x99557841UL,
+		0x8be0d7afUL, 0x335cb0caUL, 0xed59b63bUL, 0x55e5d15eUL, 0x47507eb0UL, 0xffec19d5UL,
+		0x623b216cUL, 0xda874609UL, 0xc832e9e7UL, 0x708e8e82UL, 0x28ed9ed4UL, 0x9051f9b1UL,
+		0x82e4565fUL, 0x3a58313aUL, 0xa78f0983UL, 0x1f336ee6UL, 0x0d86c108UL, 0xb53aa66dUL,
+		0xbd40e1a4UL, 0x05fc86c1UL, 0x1749292fUL, 0xaff54e4aUL, 0x322276f3UL, 0x8a9e1196UL,
+		0x982bbe78UL, 0x2097d91dUL, 0x78f4c94bUL, 0xc048ae2eUL, 0xd2fd01c0UL, 0x6a4166a5UL,
+		0xf7965e1cUL, 0x4f2a3979UL, 0x5d9f9697UL, 0xe523f1f2UL, 0x4d6b1905UL, 0xf5d77e60UL,
+		0xe762d18eUL, 0x5fdeb6ebUL, 0xc2098e52UL, 0x7ab5e937UL, 0x680046d9UL, 0xd0bc21bcUL,
+		0x88df31eaUL, 0x3063568fUL, 0x22d6f961UL, 0x9a6a9e04UL, 0x07bda6bdUL, 0xbf01c1d8UL,
+		0xadb46e36UL, 0x15080953UL, 0x1d724e9aUL, 0xa5ce29ffUL, 0xb77b8611UL, 0x0fc7e174UL,
+		0x9210d9cdUL, 0x2aacbea8UL, 0x38191146UL, 0x80a57623UL, 0xd8c66675UL, 0x607a0110UL,
+		0x72cfaefeUL, 0xca73c99bUL, 0x57a4f122UL, 0xef189647UL, 0xfdad39a9UL, 0x45115eccUL,
+		0x764dee06UL, 0xcef18963UL, 0xdc44268dUL, 0x64f841e8UL, 0xf92f7951UL, 0x41931e34UL,
+		0x5326b1daUL, 0xeb9ad6bfUL, 0xb3f9c6e9UL, 0x0b45a18cUL, 0x19f00e62UL, 0xa14c6907UL,
+		0x3c9b51beUL, 0x842736dbUL, 0x96929935UL, 0x2e2efe50UL, 0x2654b999UL, 0x9ee8defcUL,
+		0x8c5d7112UL, 0x34e11677UL, 0xa9362eceUL, 0x118a49abUL, 0x033fe645UL, 0xbb838120UL,
+		0xe3e09176UL, 0x5b5cf613UL, 0x49e959fdUL, 0xf1553e98UL, 0x6c820621UL, 0xd43e6144UL,
+		0xc68bceaaUL, 0x7e37a9cfUL, 0xd67f4138UL, 0x6ec3265dUL, 0x7c7689b3UL, 0xc4caeed6UL,
+		0x591dd66fUL, 0xe1a1b10aUL, 0xf3141ee4UL, 0x4ba87981UL, 0x13cb69d7UL, 0xab770eb2UL,
+		0xb9c2a15cUL, 0x017ec639UL, 0x9ca9fe80UL, 0x241599e5UL, 0x36a0360bUL, 0x8e1c516eUL,
+		0x866616a7UL, 0x3eda71c2UL, 0x2c6fde2cUL, 0x94d3b949UL, 0x090481f0UL, 0xb1b8e695UL,
+		0xa30d497bUL, 0x1bb12e1eUL, 0x43d23e48UL, 0xfb6e592dUL, 0xe9dbf6c3UL, 0x516791a6UL,
+		0xccb0a91fUL, 0x740cce7aUL, 0x66b96194UL, 0xde0506f1UL
+	},
+	{
+		0x00000000UL, 0x3d6029b0UL, 0x7ac05360UL, 0x47a07ad0UL, 0xf580a6c0UL, 0xc8e08f70UL,
+		0x8f40f5a0UL, 0xb220dc10UL, 0x30704bc1UL, 0x0d106271UL, 0x4ab018a1UL, 0x77d03111UL,
+		0xc5f0ed01UL, 0xf890c4b1UL, 0xbf30be61UL, 0x825097d1UL, 0x60e09782UL, 0x5d80be32UL,
+		0x1a20c4e2UL, 0x2740ed52UL, 0x95603142UL, 0xa80018f2UL, 0xefa06222UL, 0xd2c04b92UL,
+		0x5090dc43UL, 0x6df0f5f3UL, 0x2a508f23UL, 0x1730a693UL, 0xa5107a83UL, 0x98705333UL,
+		0xdfd029e3UL, 0xe2b00053UL, 0xc1c12f04UL, 0xfca106b4UL, 0xbb017c64UL, 0x866155d4UL,
+		0x344189c4UL, 0x0921a074UL, 0x4e81daa4UL, 0x73e1f314UL, 0xf1b164c5UL, 0xccd14d75UL,
+		0x8b7137a5UL, 0xb6111e15UL, 0x0431c205UL, 0x3951ebb5UL, 0x7ef19165UL, 0x4391b8d5UL,
+		0xa121b886UL, 0x9c419136UL, 0xdbe1ebe6UL, 0xe681c256UL, 0x54a11e46UL, 0x69c137f6UL,
+		0x2e614d26UL, 0x13016496UL, 0x9151f347UL, 0xac31daf7UL, 0xeb91a027UL, 0xd6f18997UL,
+		0x64d15587UL, 0x59b17c37UL, 0x1e1106e7UL, 0x23712f57UL, 0x58f35849UL, 0x659371f9UL,
+		0x22330b29UL, 0x1f532299UL, 0xad73fe89UL, 0x9013d739UL, 0xd7b3ade9UL, 0xead38459UL,
+		0x68831388UL, 0x55e33a38UL, 0x124340e8UL, 0x2f236958UL, 0x9d03b548UL, 0xa0639cf8UL,
+		0xe7c3e628UL, 0xdaa3cf98UL, 0x3813cfcbUL, 0x0573e67bUL, 0x42d39cabUL, 0x7fb3b51bUL,
+		0xcd93690bUL, 0xf0f340bbUL, 0xb7533a6bUL, 0x8a3313dbUL, 0x0863840aUL, 0x3503adbaUL,
+		0x72a3d76aUL, 0x4fc3fedaUL, 0xfde322caUL, 0xc0830b7aUL, 0x872371aaUL, 0xba43581aUL,
+		0x9932774dUL, 0xa4525efdUL, 0xe3f2242dUL, 0xde920d9dUL, 0x6cb2d18dUL, 0x51d2f83dUL,
+		0x167282edUL, 0x2b12ab5dUL, 0xa9423c8cUL, 0x9422153cUL, 0xd3826fecUL, 0xeee2465cUL,
+		0x5cc29a4cUL, 0x61a2b3fcUL, 0x2602c92cUL, 0x1b62e09cUL, 0xf9d2e0cfUL, 0xc4b2c97fUL,
+		0x8312b3afUL, 0xbe729a1fUL, 0x0c52460fUL, 0x31326fbfUL, 0x7692156fUL, 0x4bf23cdfUL,
+		0xc9a2ab0eUL, 0xf4c282beUL, 0xb362f86eUL, 0x8e02d1deUL, 0x3c220dceUL, 0x0142247eUL,
+		0x46e25eaeUL, 0x7b82771eUL, 0xb1e6b092UL, 0x8c869922UL, 0xcb26e3f2UL, 0xf646ca42UL,
+		0x44661652UL, 0x79063fe2UL, 0x3ea64532UL, 0x03c66c82UL, 0x8196fb53UL, 0xbcf6d2e3UL,
+		0xfb56a833UL, 0xc6368183UL, 0x74165d93UL, 0x49767423UL, 0x0ed60ef3UL, 0x33b62743UL,
+		0xd1062710UL, 0xec660ea0UL, 0xabc67470UL, 0x96a65dc0UL, 0x248681d0UL, 0x19e6a860UL,
+		0x5e46d2b0UL, 0x6326fb00UL, 0xe1766cd1UL, 0xdc164561UL, 0x9bb63fb1UL, 0xa6d61601UL,
+		0x14f6ca11UL, 0x2996e3a1UL, 0x6e369971UL, 0x5356b0c1UL, 0x70279f96UL, 0x4d47b626UL,
+		0x0ae7ccf6UL, 0x3787e546UL, 0x85a73956UL, 0xb8c710e6UL, 0xff676a36UL, 0xc2074386UL,
+		0x4057d457UL, 0x7d37fde7UL, 0x3a978737UL, 0x07f7ae87UL, 0xb5d77297UL, 0x88b75b27UL,
+		0xcf1721f7UL, 0xf2770847UL, 0x10c70814UL, 0x2da721a4UL, 0x6a075b74UL, 0x576772c4UL,
+		0xe547aed4UL, 0xd8278764UL, 0x9f87fdb4UL, 0xa2e7d404UL, 0x20b743d5UL, 0x1dd76a65UL,
+		0x5a7710b5UL, 0x67173905UL, 0xd537e515UL, 0xe857cca5UL, 0xaff7b675UL, 0x92979fc5UL,
+		0xe915e8dbUL, 0xd475c16bUL, 0x93d5bbbbUL, 0xaeb5920bUL, 0x1c954e1bUL, 0x21f567abUL,
+		0x66551d7bUL, 0x5b3534cbUL, 0xd965a31aUL, 0xe4058aaaUL, 0xa3a5f07aUL, 0x9ec5d9caUL,
+		0x2ce505daUL, 0x11852c6aUL, 0x562556baUL, 0x6b457f0aUL, 0x89f57f59UL, 0xb49556e9UL,
+		0xf3352c39UL, 0xce550589UL, 0x7c75d999UL, 0x4115f029UL, 0x06b58af9UL, 0x3bd5a349UL,
+		0xb9853498UL, 0x84e51d28UL, 0xc34567f8UL, 0xfe254e48UL, 0x4c059258UL, 0x7165bbe8UL,
+		0x36c5c138UL, 0x0ba5e888UL, 0x28d4c7dfUL, 0x15b4ee6fUL, 0x521494bfUL, 0x6f74bd0fUL,
+		0xdd54611fUL, 0xe03448afUL, 0xa794327fUL, 0x9af41bcfUL, 0x18a48c1eUL, 0x25c4a5aeUL,
+		0x6264df7eUL, 0x5f04f6ceUL, 0xed242adeUL, 0xd044036eUL, 0x97e479beUL, 0xaa84500eUL,
+		0x4834505dUL, 0x755479edUL, 0x32f4033dUL, 0x0f942a8dUL, 0xbdb4f69dUL, 0x80d4df2dUL,
+		0xc774a5fdUL, 0xfa148c4dUL, 0x78441b9cUL, 0x4524322cUL, 0x028448fcUL, 0x3fe4614cUL,
+		0x8dc4bd5cUL, 0xb0a494ecUL, 0xf704ee3cUL, 0xca64c78cUL
+	},
+	{
+		0x00000000UL, 0xcb5cd3a5UL, 0x4dc8a10bUL, 0x869472aeUL, 0x9b914216UL, 0x50cd91b3UL,
+		0xd659e31dUL, 0x1d0530b8UL, 0xec53826dUL, 0x270f51c8UL, 0xa19b2366UL, 0x6ac7f0c3UL,
+		0x77c2c07bUL, 0xbc9e13deUL, 0x3a0a6170UL, 0xf156b2d5UL, 0x03d6029bUL, 0xc88ad13eUL,
+		0x4e1ea390UL, 0x85427035UL, 0x9847408dUL, 0x531b9328UL, 0xd58fe186UL, 0x1ed33223UL,
+		0xef8580f6UL, 0x24d95353UL, 0xa24d21fdUL, 0x6911f258UL, 0x7414c2e0UL, 0xbf481145UL,
+		0x39dc63ebUL, 0xf280b04eUL, 0x07ac0536UL, 0xccf0d693UL, 0x4a64a43dUL, 0x81387798UL,
+		0x9c3d4720UL, 0x57619485UL, 0xd1f5e62bUL, 0x1aa9358eUL, 0xebff875bUL, 0x20a354feUL,
+		0xa6372650UL, 0x6d6bf5f5UL, 0x706ec54dUL, 0xbb3216e8UL, 0x3da66446UL, 0xf6fab7e3UL,
+		0x047a07adUL, 0xcf26d408UL, 0x49b2a6a6UL, 0x82ee7503UL, 0x9feb45bbUL, 0x54b7961eUL,
+		0xd223e4b0UL, 0x197f3715UL, 0xe82985c0UL, 0x23755665UL, 0xa5e124cbUL, 0x6ebdf76eUL,
+		0x73b8c7d6UL, 0xb8e41473UL, 0x3e7066ddUL, 0xf52cb578UL, 0x0f580a6cUL, 0xc404d9c9UL,
+		0x4290ab67UL, 0x89cc78c2UL, 0x94c9487aUL, 0x5f959bdfUL, 0xd901e971UL, 0x125d3ad4UL,
+		0xe30b8801UL, 0x28575ba4UL, 0xaec3290aUL, 0x659ffaafUL, 0x789aca17UL, 0xb3c619b2UL,
+		0x35526b1cUL, 0xfe0eb8b9UL, 0x0c8e08f7UL, 0xc7d2db52UL, 0x4146a9fcUL, 0x8a1a7a59UL,
+		0x971f4ae1UL, 0x5c439944UL, 0xdad7ebeaUL, 0x118b384fUL, 0xe0dd8a9aUL, 0x2b81593fUL,
+		0xad152b91UL, 0x6649f834UL, 0x7b4cc88cUL, 0xb0101b29UL, 0x36846987UL, 0xfdd8ba22UL,
+		0x08f40f5aUL, 0xc3a8dcffUL, 0x453cae51UL, 0x8e607df4UL, 0x93654d4cUL, 0x58399ee9UL,
+		0xdeadec47UL, 0x15f13fe2UL, 0xe4a78d37UL, 0x2ffb5e92UL, 0xa96f2c3cUL, 0x6233ff99UL,
+		0x7f36cf21UL, 0xb46a1c84UL, 0x32fe6e2aUL, 0xf9a2bd8fUL, 0x0b220dc1UL, 0xc07ede64UL,
+		0x46eaaccaUL, 0x8db67f6fUL, 0x90b34fd7UL, 0x5bef9c72UL, 0xdd7beedcUL, 0x16273d79UL,
+		0xe7718facUL, 0x2c2d5c09UL, 0xaab92ea7UL, 0x61e5fd02UL, 0x7ce0cdbaUL, 0xb7bc1e1fUL,
+		0x31286cb1UL, 0xfa74bf14UL, 0x1eb014d8UL, 0xd5ecc77dUL, 0x5378b5d3UL, 0x98246676UL,
+		0x852156ceUL, 0x4e7d856bUL, 0xc8e9f7c5UL, 0x03b52460UL, 0xf2e396b5UL, 0x39bf4510UL,
+		0xbf2b37beUL, 0x7477e41bUL, 0x6972d4a3UL, 0xa22e0706UL, 0x24ba75a8UL, 0xefe6a60dUL,
+		0x1d661643UL, 0xd63ac5e6UL, 0x50aeb748UL, 0x9bf264edUL, 0x86f75455UL, 0x4dab87f0UL,
+		0xcb3ff55eUL, 0x006326fbUL, 0xf135942eUL, 0x3a69478bUL, 0xbcfd3525UL, 0x77a1e680UL,
+		0x6aa4d638UL, 0xa1f8059dUL, 0x276c7733UL, 0xec30a496UL, 0x191c11eeUL, 0xd240c24bUL,
+		0x54d4b0e5UL, 0x9f886340UL, 0x828d53f8UL, 0x49d1805dUL, 0xcf45f2f3UL, 0x04192156UL,
+		0xf54f9383UL, 0x3e134026UL, 0xb8873288UL, 0x73dbe12dUL, 0x6eded195UL, 0xa5820230UL,
+		0x2316709eUL, 0xe84aa33bUL, 0x1aca1375UL, 0xd196c0d0UL, 0x5702b27eUL, 0x9c5e61dbUL,
+		0x815b5163UL, 0x4a0782c6UL, 0xcc93f068UL, 0x07cf23cdUL, 0xf6999118UL, 0x3dc542bdUL,
+		0xbb513013UL, 0x700de3b6UL, 0x6d08d30eUL, 0xa65400abUL, 0x20c07205UL, 0xeb9ca1a0UL,
+		0x11e81eb4UL, 0xdab4cd11UL, 0x5c20bfbfUL, 0x977c6c1aUL, 0x8a795ca2UL, 0x41258f07UL,
+		0xc7b1fda9UL, 0x0ced2e0cUL, 0xfdbb9cd9UL, 0x36e74f7cUL, 0xb0733dd2UL, 0x7b2fee77UL,
+		0x662adecfUL, 0xad760d6aUL, 0x2be27fc4UL, 0xe0beac61UL, 0x123e1c2fUL, 0xd962cf8aUL,
+		0x5ff6bd24UL, 0x94aa6e81UL, 0x89af5e39UL, 0x42f38d9cUL, 0xc467ff32UL, 0x0f3b2c97UL,
+		0xfe6d9e42UL, 0x35314de7UL, 0xb3a53f49UL, 0x78f9ececUL, 0x65fcdc54UL, 0xaea00ff1UL,
+		0x28347d5fUL, 0xe368aefaUL, 0x16441b82UL, 0xdd18c827UL, 0x5b8cba89UL, 0x90d0692cUL,
+		0x8dd55994UL, 0x46898a31UL, 0xc01df89fUL, 0x0b412b3aUL, 0xfa1799efUL, 0x314b4a4aUL,
+		0xb7df38e4UL, 0x7c83eb41UL, 0x6186dbf9UL, 0xaada085cUL, 0x2c4e7af2UL, 0xe712a957UL,
+		0x15921919UL, 0xdececabcUL, 0x585ab812UL, 0x93066bb7UL, 0x8e035b0fUL, 0x455f88aaUL,
+		0xc3cbfa04UL, 0x089729a1UL, 0xf9c19b74UL, 0x329d48d1UL, 0xb4093a7fUL, 0x7f55e9daUL,
+		0x6250d962UL, 0xa90c0ac7UL, 0x2f987869UL, 0xe4c4abccUL
+	},
+	{
+		0x00000000UL, 0xa6770bb4UL, 0x979f1129UL, 0x31e81a9dUL, 0xf44f2413UL, 0x52382fa7UL,
+		0x63d0353aUL, 0xc5a73e8eUL, 0x33ef4e67UL, 0x959845d3UL, 0xa4705f4eUL, 0x020754faUL,
+		0xc7a06a74UL, 0x61d761c0UL, 0x503f7b5dUL, 0xf64870e9UL, 0x67de9cceUL, 0xc1a9977aUL,
+		0xf0418de7UL, 0x56368653UL, 0x9391b8ddUL, 0x35e6b369UL, 0x040ea9f4UL, 0xa279a240UL,
+		0x5431d2a9UL, 0xf246d91dUL, 0xc3aec380UL, 0x65d9c834UL, 0xa07ef6baUL, 0x0609fd0eUL,
+		0x37e1e793UL, 0x9196ec27UL, 0xcfbd399cUL, 0x69ca3228UL, 0x582228b5UL, 0xfe552301UL,
+		0x3bf21d8fUL, 0x9d85163bUL, 0xac6d0ca6UL, 0x0a1a0712UL, 0xfc5277fbUL, 0x5a257c4fUL,
+		0x6bcd66d2UL, 0xcdba6d66UL, 0x081d53e8UL, 0xae6a585cUL, 0x9f8242c1UL, 0x39f54975UL,
+		0xa863a552UL, 0x0e14aee6UL, 0x3ffcb47bUL, 0x998bbfcfUL, 0x5c2c8141UL, 0xfa5b8af5UL,
+		0xcbb39068UL, 0x6dc49bdcUL, 0x9b8ceb35UL, 0x3dfbe081UL, 0x0c13fa1cUL, 0xaa64f1a8UL,
+		0x6fc3cf26UL, 0xc9b4c492UL, 0xf85cde0fUL, 0x5e2bd5bbUL, 0x440b7579UL, 0xe27c7ecdUL,
+		0xd3946450UL, 0x75e36fe4UL, 0xb044516aUL, 0x16335adeUL, 0x27db4043UL, 0x81ac4bf7UL,
+		0x77e43b1eUL, 0xd19330aaUL, 0xe07b2a37UL, 0x460c2183UL, 0x83ab1f0dUL, 0x25dc14b9UL,
+		0x14340e24UL, 0xb2430590UL, 0x23d5e9b7UL, 0x85a2e203UL, 0xb44af89eUL, 0x123df32aUL,
+		0xd79acda4UL, 0x71edc610UL, 0x4005dc8dUL, 0xe672d739UL, 0x103aa7d0UL, 0xb64dac64UL,
+		0x87a5b6f9UL, 0x21d2bd4dUL, 0xe47583c3UL, 0x42028877UL, 0x73ea92eaUL, 0xd59d995eUL,
+		0x8bb64ce5UL, 0x2dc14751UL, 0x1c295dccUL, 0xba5e5678UL, 0x7ff968f6UL, 0xd98e6342UL,
+		0xe86679dfUL, 0x4e11726bUL, 0xb8590282UL, 0x1e2e0936UL, 0x2fc613abUL, 0x89b1181fUL,
+		0x4c162691UL, 0xea612d25UL, 0xdb8937b8UL, 0x7dfe3c0cUL, 0xec68d02bUL, 0x4a1fdb9fUL,
+		0x7bf7c102UL, 0xdd80cab6UL, 0x1827f438UL, 0xbe50ff8cUL, 0x8fb8e511UL, 0x29cfeea5UL,
+		0xdf879e4cUL, 0x79f095f8UL, 0x48188f65UL, 0xee6f84d1UL, 0x2bc8ba5fUL, 0x8dbfb1ebUL,
+		0xbc57ab76UL, 0x1a20a0c2UL, 0x8816eaf2UL, 0x2e61e146UL, 0x1f89fbdbUL, 0xb9fef06fUL,
+		0x7c59cee1UL, 0xda2ec555UL, 0xebc6dfc8UL, 0x4db1d47cUL, 0xbbf9a495UL, 0x1d8eaf21UL,
+		0x2c66b5bcUL, 0x8a11be08UL, 0x4fb68086UL, 0xe9c18b32UL, 0xd82991afUL, 0x7e5e9a1bUL,
+		0xefc8763cUL, 0x49bf7d88UL, 0x78576715UL, 0xde206ca1UL, 0x1b87522fUL, 0xbdf0599bUL,
+		0x8c184306UL, 0x2a6f48b2UL, 0xdc27385bUL, 0x7a5033efUL, 0x4bb82972UL, 0xedcf22c6UL,
+		0x28681c48UL, 0x8e1f17fcUL, 0xbff70d61UL, 0x198006d5UL, 0x47abd36eUL, 0xe1dcd8daUL,
+		0xd034c247UL, 0x7643c9f3UL, 0xb3e4f77dUL, 0x1593fcc9UL, 0x247be654UL, 0x820cede0UL,
+		0x74449d09UL, 0xd23396bdUL, 0xe3db8c20UL, 0x45ac8794UL, 0x800bb91aUL, 0x267cb2aeUL,
+		0x1794a833UL, 0xb1e3a387UL, 0x20754fa0UL, 0x86024414UL, 0xb7ea5e89UL, 0x119d553dUL,
+		0xd43a6bb3UL, 0x724d6007UL, 0x43a57a9aUL, 0xe5d2712eUL, 0x139a01c7UL, 0xb5ed0a73UL,
+		0x840510eeUL, 0x22721b5aUL, 0xe7d525d4UL, 0x41a22e60UL, 0x704a34fdUL, 0xd63d3f49UL,
+		0xcc1d9f8bUL, 0x6a6a943fUL, 0x5b828ea2UL, 0xfdf58516UL, 0x3852bb98UL, 0x9e25b02cUL,
+		0xafcdaab1UL, 0x09baa105UL, 0xfff2d1ecUL, 0x5985da58UL, 0x686dc0c5UL, 0xce1acb71UL,
+		0x0bbdf5ffUL, 0xadcafe4bUL, 0x9c22e4d6UL, 0x3a55ef62UL, 0xabc30345UL, 0x0db408f1UL,
+		0x3c5c126cUL, 0x9a2b19d8UL, 0x5f8c2756UL, 0xf9fb2ce2UL, 0xc813367fUL, 0x6e643dcbUL,
+		0x982c4d22UL, 0x3e5b4696UL, 0x0fb35c0bUL, 0xa9c457bfUL, 0x6c636931UL, 0xca146285UL,
+		0xfbfc7818UL, 0x5d8b73acUL, 0x03a0a617UL, 0xa5d7ada3UL, 0x943fb73eUL, 0x3248bc8aUL,
+		0xf7ef8204UL, 0x519889b0UL, 0x6070932dUL, 0xc6079899UL, 0x304fe870UL, 0x9638e3c4UL,
+		0xa7d0f959UL, 0x01a7f2edUL, 0xc400cc63UL, 0x6277c7d7UL, 0x539fdd4aUL, 0xf5e8d6feUL,
+		0x647e3ad9UL, 0xc209316dUL, 0xf3e12bf0UL, 0x55962044UL, 0x90311ecaUL, 0x3646157eUL,
+		0x07ae0fe3UL, 0xa1d90457UL, 0x579174beUL, 0xf1e67f0aUL, 0xc00e6597UL, 0x66796e23UL,
+		0xa3de50adUL, 0x05a95b19UL, 0x34414184UL, 0x92364a30UL
+	},
+	{
+		0x00000000UL, 0xccaa009eUL, 0x4225077dUL, 0x8e8f07e3UL, 0x844a0efaUL, 0x48e00e64UL,
+		0xc66f0987UL, 0x0ac50919UL, 0xd3e51bb5UL, 0x1f4f1b2bUL, 0x91c01cc8UL, 0x5d6a1c56UL,
+		0x57af154fUL, 0x9b0515d1UL, 0x158a1232UL, 0xd92012acUL, 0x7cbb312bUL, 0xb01131b5UL,
+		0x3e9e3656UL, 0xf23436c8UL, 0xf8f13fd1UL, 0x345b3f4fUL, 0xbad438acUL, 0x767e3832UL,
+		0xaf5e2a9eUL, 0x63f42a00UL, 0xed7b2de3UL, 0x21d12d7dUL, 0x2b142464UL, 0xe7be24faUL,
+		0x69312319UL, 0xa59b2387UL, 0xf9766256UL, 0x35dc62c8UL, 0xbb53652bUL, 0x77f965b5UL,
+		0x7d3c6cacUL, 0xb1966c32UL, 0x3f196bd1UL, 0xf3b36b4fUL, 0x2a9379e3UL, 0xe639797dUL,
+		0x68b67e9eUL, 0xa41c7e00UL, 0xaed97719UL, 0x62737787UL, 0xecfc7064UL, 0x205670faUL,
+		0x85cd537dUL, 0x496753e3UL, 0xc7e85400UL, 0x0b42549eUL, 0x01875d87UL, 0xcd2d5d19UL,
+		0x43a25afaUL, 0x8f085a64UL, 0x562848c8UL, 0x9a824856UL, 0x140d4fb5UL, 0xd8a74f2bUL,
+		0xd2624632UL, 0x1ec846acUL, 0x9047414fUL, 0x5ced41d1UL, 0x299dc2edUL, 0xe537c273UL,
+		0x6bb8c590UL, 0xa712c50eUL, 0xadd7cc17UL, 0x617dcc89UL, 0xeff2cb6aUL, 0x2358cbf4UL,
+		0xfa78d958UL, 0x36d2d9c6UL, 0xb85dde25UL, 0x74f7debbUL, 0x7e32d7a2UL, 0xb298d73cUL,
+		0x3c17d0dfUL, 0xf0bdd041UL, 0x5526f3c6UL, 0x998cf358UL, 0x1703f4bbUL, 0xdba9f425UL,
+		0xd16cfd3cUL, 0x1dc6fda2UL, 0x9349fa41UL, 0x5fe3fadfUL, 0x86c3e873UL, 0x4a69e8edUL,
+		0xc4e6ef0eUL, 0x084cef90UL, 0x0289e689UL, 0xce23e617UL, 0x40ace1f4UL, 0x8c06e16aUL,
+		0xd0eba0bbUL, 0x1c41a025UL, 0x92cea7c6UL, 0x5e64a758UL, 0x54a1ae41UL, 0x980baedfUL,
+		0x1684a93cUL, 0xda2ea9a2UL, 0x030ebb0eUL, 0xcfa4bb90UL, 0x412bbc73UL, 0x8d81bcedUL,
+		0x8744b5f4UL, 0x4beeb56aUL, 0xc561b289UL, 0x09cbb217UL, 0xac509190UL, 0x60fa910eUL,
+		0xee7596edUL, 0x22df9673UL, 0x281a9f6aUL, 0xe4b09ff4UL, 0x6a3f9817UL, 0xa6959889UL,
+		0x7fb58a25UL, 0xb31f8abbUL, 0x3d908d58UL, 0xf13a8dc6UL, 0xfbff84dfUL, 0x37558441UL,
+		0xb9da83a2UL, 0x7570833cUL, 0x533b85daUL, 0x9f918544UL, 0x111e82a7UL, 0xddb48239UL,
+		0xd7718b20UL, 0x1bdb8bbeUL, 0x95548c5dUL, 0x59fe8cc3UL, 0x80de9e6fUL, 0x4c749ef1UL,
+		0xc2fb9912UL, 0x0e51998cUL, 0x04949095UL, 0xc83e900bUL, 0x46b197e8UL, 0x8a1b9776UL,
+		0x2f80b4f1UL, 0xe32ab46fUL, 0x6da5b38cUL, 0xa10fb312UL, 0xabcaba0bUL, 0x6760ba95UL,
+		0xe9efbd76UL, 0x2545bde8UL, 0xfc65af44UL, 0x30cfafdaUL, 0xbe40a839UL, 0x72eaa8a7UL,
+		0x782fa1beUL, 0xb485a120UL, 0x3a0aa6c3UL, 0xf6a0a65dUL, 0xaa4de78cUL, 0x66e7e712UL,
+		0xe868e0f1UL, 0x24c2e06fUL, 0x2e07e976UL, 0xe2ade9e8UL, 0x6c22ee0bUL, 0xa088ee95UL,
+		0x79a8fc39UL, 0xb502fca7UL, 0x3b8dfb44UL, 0xf727fbdaUL, 0xfde2f2c3UL, 0x3148f25dUL,
+		0xbfc7f5beUL, 0x736df520UL, 0xd6f6d6a7UL, 0x1a5cd639UL, 0x94d3d1daUL, 0x5879d144UL,
+		0x52bcd85dUL, 0x9e16d8c3UL, 0x1099df20UL, 0xdc33dfbeUL, 0x0513cd12UL, 0xc9b9cd8cUL,
+		0x4736ca6fUL, 0x8b9ccaf1UL, 0x8159c3e8UL, 0x4df3c376UL, 0xc37cc495UL, 0x0fd6c40bUL,
+		0x7aa64737UL, 0xb60c47a9UL, 0x3883404aUL, 0xf42940d4UL, 0xfeec49cdUL, 0x32464953UL,
+		0xbcc94eb0UL, 0x70634e2eUL, 0xa9435c82UL, 0x65e95c1cUL, 0xeb665bffUL, 0x27cc5b61UL,
+		0x2d095278UL, 0xe1a352e6UL, 0x6f2c5505UL, 0xa386559bUL, 0x061d761cUL, 0xcab77682UL,
+		0x44387161UL, 0x889271ffUL, 0x825778e6UL, 0x4efd7878UL, 0xc0727f9bUL, 0x0cd87f05UL,
+		0xd5f86da9UL, 0x19526d37UL, 0x97dd6ad4UL, 0x5b776a4aUL, 0x51b26353UL, 0x9d1863cdUL,
+		0x1397642eUL, 0xdf3d64b0UL, 0x83d02561UL, 0x4f7a25ffUL, 0xc1f5221cUL, 0x0d5f2282UL,
+		0x079a2b9bUL, 0xcb302b05UL, 0x45bf2ce6UL, 0x89152c78UL, 0x50353ed4UL, 0x9c9f3e4aUL,
+		0x121039a9UL, 0xdeba3937UL, 0xd47f302eUL, 0x18d530b0UL, 0x965a3753UL, 0x5af037cdUL,
+		0xff6b144aUL, 0x33c114d4UL, 0xbd4e1337UL, 0x71e413a9UL, 0x7b211ab0UL, 0xb78b1a2eUL,
+		0x39041dcdUL, 0xf5ae1d53UL, 0x2c8e0fffUL, 0xe0240f61UL, 0x6eab0882UL, 0xa201081cUL,
+		0xa8c40105UL, 0x646e019bUL, 0xeae10678UL, 0x264b06e6UL
+	}
+};
+
+u32 crc32_slice (u32, const u8*, int);
+#ifdef COMP_HAVE_PCLMUL
+/* below this, setting up the folds costs more than the tables save */
+#define CRC32_FOLD_MINIMUM 64
+u32 crc32_fold (u32, const u8*, int);
+#endif
+
 const int NEW_BLOCK = 0;
 const int GET_BLOCK_LENGTH = 1;						/* jump here if no compression */
 const int COPY_BLOCK_TO_DEST = 2;
-const int LOAD_DEFAULT_CODE_LENGTHS= 3;				/* jump here if fixed Huffman coding */
+const int LOAD_FIXED_DECODE_TABLES = 3;				/* jump here if fixed Huffman coding */
 const int BUILD_CODE_TREES = 4;		
 const int DECODE_DATA = 5;
 const int READ_LENGTH_EXTRA_BITS = 6;
@@ -42,445 +583,1505 @@ const int READ_CODE_LENGTH_CODE_LENGTHS = 11;
 const int BUILD_CODE_LENGTH_CODE_TREE = 12;
 const int READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS = 13;
 
-int comp_inflate (u8* dest, int dest_size, const u8* src, int src_size) {
+/* results of inflate_blocks() */
+#define INFLATE_STREAM_END 1
+#define INFLATE_NEED_INPUT 2
+#define INFLATE_NEED_OUTPUT 3
+#define INFLATE_ERROR -1
+
+#define MAX_MATCH_LENGTH 258
+/* inflate_fast() needs a whole word of input left for each refill */
+#define INFLATE_FAST_MIN_INPUT 8
 
+#define COMP_WINDOW_SIZE 32768
+#define COMP_WINDOW_BUFFER_SIZE (2 * COMP_WINDOW_SIZE)
+
+/* All of the decoder's state lives here so that decoding can stop whenever
+   the input or the output runs out and resume on the next call. Everything
+   in out before out_pos is history that matches may refer to. comp_inflate()
+   decodes straight into the caller's buffer; a comp_stream decodes into its
+   own window, which comp_inflate_drain() copies out and slides down. */
+struct comp_Stream {
 	int block_state, last_block_bool;
-	u32 index, size; /* index into source and size written to dest */
-	u16 length_value, distance_value;
-	int bit;
-	pair contiguous_trees[LITERAL_LENGTH_TREE_SIZE + DISTANCE_TREE_SIZE];
-	pair *ll_tree, *d_tree;
-	pair cl_tree[CODE_LENGTH_TREE_SIZE];
+	int status;			/* last result of inflate_blocks() */
+	bit_reader br;
+	u8* out;
+	u32 out_size, out_pos;
+	u8* window;			/* comp_stream only */
+	u32 drained;		/* comp_stream only: window bytes handed out */
+	u32 length_value, distance_value;
 	u16 hlit, hdist, hclen;
+	int lengths_read;	/* progress through the code length states */
+	u8 lengths[LITERAL_LENGTH_TREE_SIZE + DISTANCE_TREE_SIZE]; /* ll then d */
+	u8 cl_lengths[CODE_LENGTH_TREE_SIZE];
+	table_entry ll_table[LITERAL_LENGTH_TABLE_SIZE];
+	table_entry d_table[DISTANCE_TABLE_SIZE];
+	table_entry cl_table[CODE_LENGTH_TABLE_SIZE];
+	const table_entry *ll_decode, *d_decode; /* tables of the current block */
+};
+
+void inflate_reset (struct comp_Stream*);
+int inflate_blocks (struct comp_Stream*);
+int inflate_fast (struct comp_Stream*);
+
+int comp_inflate (u8* dest, int dest_size, const u8* src, int src_size) {
+
+	/* the whole input is here, so decode straight into dest */
+	struct comp_Stream s;
+	inflate_reset (&s);
+	s.out = dest;
+	s.out_size = dest_size;
+	s.window = NULL;
+	bits_feed (&s.br, src, src_size, 1);
+
+	if (inflate_blocks (&s) == INFLATE_ERROR)
+		return -1;
+	return s.out_pos;
+}
+
+int comp_inflate_crc (u8* dest, int dest_size, const u8* src, int src_size, u32* crc) {
+
+	/* as comp_inflate(), but the output is let out one window at a time and
+	   each window is checksummed while it is still in cache */
+	struct comp_Stream s;
+	int status;
+	u32 checked;
+	inflate_reset (&s);
+	s.out = dest;
+	s.window = NULL;
+	bits_feed (&s.br, src, src_size, 1);
 
-	ll_tree = & (contiguous_trees[0]);
-	d_tree = & (contiguous_trees[LITERAL_LENGTH_TREE_SIZE]);
-	hlit = LITERAL_LENGTH_TREE_SIZE;
-	hdist = DISTANCE_TREE_SIZE;
-
-	block_state = NEW_BLOCK;
-	last_block_bool = 0;
-	index = 0;
-	length_value = 0;
-	size = 0;
-	bit = 0;
-	while ((index < src_size && size < dest_size) && 
-		!(last_block_bool && (NEW_BLOCK == block_state))) {
-		/* (src and dest bounds check)       
-		 * && (not end of last block)	*/
-
-		if (block_state == NEW_BLOCK) {
+	checked = 0;
+	*crc = comp_crc32 (0, NULL, 0);
+	do {
+		s.out_size = (dest_size - s.out_pos > COMP_WINDOW_SIZE) ? s.out_pos + COMP_WINDOW_SIZE : dest_size;
+		status = inflate_blocks (&s);
+		if (status == INFLATE_ERROR)
+			return -1;
+		*crc = comp_crc32 (*crc, dest + checked, s.out_pos - checked);
+		checked = s.out_pos;
+	} while (status == INFLATE_NEED_OUTPUT && s.out_size < dest_size);
+	return s.out_pos;
+}
+
+void comp_inflate_init (struct comp_Stream** ptr_ptr) {
+
+	/* allocate the object and its window in memory */
+	*ptr_ptr = (struct comp_Stream*) malloc (sizeof (struct comp_Stream));
+	struct comp_Stream* s = *ptr_ptr;
+	if (!s)
+		printf ("memory allocation failure\n"), exit (EXIT_FAILURE);
+	s->window = malloc (COMP_WINDOW_BUFFER_SIZE);
+	if (!s->window)
+		printf ("memory allocation failure\n"), exit (EXIT_FAILURE);
+
+	inflate_reset (s);
+	s->out = s->window;
+	s->out_size = COMP_WINDOW_BUFFER_SIZE;
+	s->drained = 0;
+}
+
+void comp_inflate_end (struct comp_Stream** ptr_ptr) {
+	free ((*ptr_ptr)->window);
+	free (*ptr_ptr);
+	*ptr_ptr = NULL;
+}
+
+void comp_inflate_feed (struct comp_Stream* s, const u8* src, int src_size, int last_chunk) {
+	bits_feed (&s->br, src, src_size, last_chunk);
+}
+
+int comp_inflate_drain (struct comp_Stream* s, u8* dest, int dest_size) {
+
+	int written;
+	if (s->status == INFLATE_ERROR)
+		return -1;
+
+	written = 0;
+	while (written < dest_size) {
+
+		/* hand out what has already been decoded */
+		if (s->drained < s->out_pos) {
+			u32 n;
+			n = s->out_pos - s->drained;
+			if (n > dest_size - written)
+				n = dest_size - written;
+			memcpy (dest + written, s->window + s->drained, n);
+			s->drained += n;
+			written += n;
+			continue;
+		}
+		if (s->status == INFLATE_STREAM_END)
+			break;
+
+		/* everything is drained, so only the last 32 KiB must be kept */
+		if (s->out_pos > COMP_WINDOW_SIZE) {
+			memmove (s->window, s->window + s->out_pos - COMP_WINDOW_SIZE, COMP_WINDOW_SIZE);
+			s->out_pos = COMP_WINDOW_SIZE;
+			s->drained = COMP_WINDOW_SIZE;
+		}
+
+		/* decode until the window fills or the input runs out */
+		s->status = inflate_blocks (s);
+		if (s->status == INFLATE_ERROR)
+			return -1;
+		if (s->drained == s->out_pos)
+			break;
+	}
+	return written;
+}
+
+int comp_inflate_finished (struct comp_Stream* s) {
+	return s->status == INFLATE_STREAM_END && s->drained == s->out_pos;
+}
+
+void inflate_reset (struct comp_Stream* s) {
+	s->block_state = NEW_BLOCK;
+	s->last_block_bool = 0;
+	s->status = INFLATE_NEED_INPUT;
+	bits_init (&s->br);
+	s->out_pos = 0;
+	s->length_value = 0;
+	s->distance_value = 0;
+	s->hlit = LITERAL_LENGTH_TREE_SIZE;
+	s->hdist = DISTANCE_TREE_SIZE;
+	s->hclen = 0;
+	s->lengths_read = 0;
+	s->ll_decode = s->ll_table;
+	s->d_decode = s->d_table;
+}
+
+int inflate_blocks (struct comp_Stream* s) {
+
+	/* Each state consumes its bits only once all of them are available, and
+	   otherwise returns INFLATE_NEED_INPUT to be resumed in the same state.
+	   With the last input chunk the bit reader pads with zeros instead, and
+	   reading into the padding is an error. */
+	bit_reader* br;
+	br = &s->br;
+	while (!(s->last_block_bool && (NEW_BLOCK == s->block_state))) {
+
+		if (s->block_state == NEW_BLOCK) {
 			/* Read the first 3 bits to determine the compression coding */
-			printf ("NEW_BLOCK, src[index]=%d\n", src[index]);
-			last_block_bool = get_bit (src, &index, &bit);
+			if (!bits_have (br, 3))
+				return INFLATE_NEED_INPUT;
+			TRACE_DETAIL ("NEW_BLOCK, next byte=%d\n", (int) bits_peek (br, 8));
+			s->last_block_bool = bits_get (br, 1);
 			u8 btype;
-			btype = get_data_element (src, &index, &bit, 2);
-			printf ("NEW_BLOCK, last_block_bool=%d, btype=%d\n", last_block_bool, btype);
+			btype = bits_get (br, 2);
+			TRACE_BLOCK ("NEW_BLOCK, last_block_bool=%d, btype=%d\n", s->last_block_bool, btype);
 			/* go to next state based on compression type */
 			if (btype == 0)
-				block_state = GET_BLOCK_LENGTH;
+				s->block_state = GET_BLOCK_LENGTH;
 			else if (btype == 1)
-				block_state = LOAD_DEFAULT_CODE_LENGTHS;
+				s->block_state = LOAD_FIXED_DECODE_TABLES;
 			else if (btype == 2)
-				block_state = READ_TREE_METADATA;
+				s->block_state = READ_TREE_METADATA;
 			else {
 				fprintf (stderr, "Error: deflated file has bad BTYPE.\n");
-				return -1;
+				return INFLATE_ERROR;
 			}
 		}
 
-		if (block_state == GET_BLOCK_LENGTH)
+		if (s->block_state == GET_BLOCK_LENGTH)
 		{
 			u16 len, nlen;
 			/* skip to the next byte boundry and read LEN of the block */
-			while (bit % 8) {
-				bit++;
-				index += bit / 8;
-				bit %= 8;
+			bits_align (br);
+			if (!bits_have (br, 32))
+				return INFLATE_NEED_INPUT;
+			len = bits_get (br, 16);
+			nlen = bits_get (br, 16);
+			TRACE_BLOCK ("GET_BLOCK_LENGTH, len=%d, ~nlen=%d\n", len, (u16) ~nlen);
+			if (len != (u16) ~nlen) {
+				fprintf (stderr, "in comp_inflate(), stored block LEN does not match NLEN.\n");
+				return INFLATE_ERROR;
 			}
-			len = get_data_element (src, &index, &bit, 16);
-			nlen = get_data_element (src, &index, &bit, 16);
-			printf ("GET_BLOCK_LENGTH, len=%d, ~nlen=%d\n", len, ~nlen);
-			break;
-			
+
+			/* go to next state */
+			s->length_value = len;
+			s->block_state = COPY_BLOCK_TO_DEST;
+		}
+
+		else if (s->block_state == COPY_BLOCK_TO_DEST)
+		{
+			/* copy as much of the stored block as fits in one piece */
+			u32 n;
+			n = s->length_value;
+			if (n > s->out_size - s->out_pos)
+				n = s->out_size - s->out_pos;
+			n = bits_copy_bytes (br, s->out + s->out_pos, n);
+			s->out_pos += n;
+			s->length_value -= n;
+			if (bits_overrun (br) || (s->length_value && br->final && s->out_pos < s->out_size)) {
+				fprintf (stderr, "in comp_inflate(), stored block is truncated.\n");
+				return INFLATE_ERROR;
+			}
+			if (s->length_value)
+				return (s->out_pos == s->out_size) ? INFLATE_NEED_OUTPUT : INFLATE_NEED_INPUT;
+
+			/* go to next state */
+			s->block_state = NEW_BLOCK;
 		}
 	
-		else if (block_state == LOAD_DEFAULT_CODE_LENGTHS)
+		else if (s->block_state == LOAD_FIXED_DECODE_TABLES)
 		{
-			printf ("LOAD_DEFAULT_CODE_LENGTHS\n");
-			/* reset the code trees with 0 codes */
-			initialize_pair_array (ll_tree, LITERAL_LENGTH_TREE_SIZE);
-			initialize_pair_array (d_tree, DISTANCE_TREE_SIZE);
-
-			/* Load the fixed code lengths listed on page 11 of the Spec. */
-			for (int i=0; i<144; i++)
-				ll_tree[i].key = (1 << 8);
-			for (int i=144; i<256; i++)
-				ll_tree[i].key = (1 << 9);
-			for (int i=256; i<280; i++)
-				ll_tree[i].key = (1 << 7);
-			for (int i=280; i<288; i++)
-				ll_tree[i].key = (1 << 8);
-			for (int i=0; i<DISTANCE_TREE_SIZE; i++)
-				d_tree[i].key = (1 << 5);			
+			TRACE_BLOCK ("LOAD_FIXED_DECODE_TABLES\n");
+			/* the fixed code tables are constant, there is nothing to build */
+			s->ll_decode = FIXED_LITERAL_LENGTH_TABLE;
+			s->d_decode = FIXED_DISTANCE_TABLE;
 
 			/* go to next state */
-			block_state = BUILD_CODE_TREES;
+			s->block_state = DECODE_DATA;
 		}
 
-		else if (block_state == BUILD_CODE_TREES)
+		else if (s->block_state == BUILD_CODE_TREES)
 		{
-			printf ("BUILD_CODE_TREES\n");
-			/* sort the code trees by code length, then literal value */
-			qsort (ll_tree, hlit, sizeof (ll_tree[0]), pair_cmp);
-			qsort (d_tree, hdist, sizeof (d_tree[0]), pair_cmp);
-
-			/* assign literal/length codes based on code length and order in array */
-			u32 new_code, prev_length_bit;
-			new_code = 0;
-			prev_length_bit = 1;
-			for (int i=0; i<hlit; i++) {
-				/* if the code length bit is 1 or 0, code is not used */
-				if (ll_tree[i].key <= 1)
-					continue;
-				/* if the code length changes, bit shift code by delta length */
-				if (ll_tree[i].key > prev_length_bit) {
-					new_code *= (ll_tree[i].key / prev_length_bit);
-					prev_length_bit = ll_tree[i].key;
-				}
-				ll_tree[i].key |= new_code;
-				new_code++;
+			TRACE_BLOCK ("BUILD_CODE_TREES\n");
+			/* every block must be able to end */
+			if (!s->lengths[END_OF_BLOCK]) {
+				fprintf (stderr, "in comp_inflate(), dynamic block has no end-of-block code.\n");
+				return INFLATE_ERROR;
 			}
 
-			/* assign distance codes */
-			new_code = 0;
-			prev_length_bit = 1;
-			for (int i=0; i<hdist; i++) {
-				/* if the code length bit is 1 or 0, code is not used */
-				if (d_tree[i].key <= 1)
-					continue;
-				if (d_tree[i].key > prev_length_bit) {
-					new_code *= (d_tree[i].key / prev_length_bit);
-					prev_length_bit = d_tree[i].key;
-				}
-				d_tree[i].key |= new_code;
-				new_code++;
+			/* assign the canonical codes straight into the decoding tables */
+			if (build_decode_table (s->ll_table, LITERAL_LENGTH_TABLE_SIZE,
+				LITERAL_LENGTH_ROOT_BITS, s->lengths, s->hlit)
+			) {
+				fprintf (stderr, "in comp_inflate(), invalid literal/length code lengths.\n");
+				return INFLATE_ERROR;
+			}
+			if (build_decode_table (s->d_table, DISTANCE_TABLE_SIZE,
+				DISTANCE_ROOT_BITS, s->lengths + s->hlit, s->hdist)
+			) {
+				fprintf (stderr, "in comp_inflate(), invalid distance code lengths.\n");
+				return INFLATE_ERROR;
 			}
+			s->ll_decode = s->ll_table;
+			s->d_decode = s->d_table;
 		
 			/* go to next state */
-			block_state = DECODE_DATA;
+			s->block_state = DECODE_DATA;
 		}
 
-		else if (block_state == DECODE_DATA)
+		else if (s->block_state == DECODE_DATA)
 		{
-			pair* match;
-			pair code;
-
-			/* parse bitwise until a length/literal code is found */
-			match = NULL;
-			code.key = 1; /* 1 is the length indicator bit */
-				while (!match && (code.key < (ULONG_MAX / 2))) {
-					code.key <<= 1;
-					code.key += get_bit (src, &index, &bit);
-					match = bsearch ((void*) &code, (void*) ll_tree, hlit, sizeof (ll_tree[0]), key_cmp);	
-				}
+			int symbol, bits;
+
+			/* the bulk of the block goes through the fast loop; near the end of
+			   the input or the output, symbols are decoded one state at a time */
+			if (inflate_fast (s) == INFLATE_ERROR)
+				return INFLATE_ERROR;
+			if (s->block_state != DECODE_DATA)
+				continue;
 
+			/* look the next literal/length code up in the decoding table */
+			symbol = peek_symbol (s->ll_decode, LITERAL_LENGTH_ROOT_BITS, br, &bits);
+			if (symbol == DECODE_NEED_INPUT)
+				return INFLATE_NEED_INPUT;
 
-			/* if no match was found, then the data must be bad */
-			if (!match)
-				return size;
+			/* if no code matched, then the data must be bad */
+			if (symbol < 0 || symbol > MAX_LENGTH_CODE) {
+				fprintf (stderr, "in comp_inflate(), invalid literal/length code.\n");
+				return INFLATE_ERROR;
+			}
 
 			/* take action and choose next state base on the literal/length value */
-			if (match->value < 256) {
-				dest[size++] = match->value;
-				block_state = DECODE_DATA;
+			if (symbol < 256) {
+				if (s->out_pos == s->out_size)
+					return INFLATE_NEED_OUTPUT;
+				s->out[s->out_pos++] = symbol;
+				s->block_state = DECODE_DATA;
 			}
-			else if (match->value == 256) {
-				block_state = NEW_BLOCK;
+			else if (symbol == END_OF_BLOCK) {
+				s->block_state = NEW_BLOCK;
 			}
 			else {
-				length_value = match->value;
-				block_state = READ_LENGTH_EXTRA_BITS;				
+				s->length_value = symbol;
+				s->block_state = READ_LENGTH_EXTRA_BITS;				
 			}
+			bits_consume (br, bits);
 		}
 
-		else if (block_state == READ_LENGTH_EXTRA_BITS) 
+		else if (s->block_state == READ_LENGTH_EXTRA_BITS) 
 		{
-			/* the length code extra bit table from page 11 of the Deflate spec. */
-			u16 BASE_LENGTH[MAX_LENGTH_CODE - MIN_LENGTH_CODE + 1] = {
-				3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
-			};
-			u8 EXTRA_BITS[MAX_LENGTH_CODE - MIN_LENGTH_CODE + 1] = {
-				0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
-			};
-			
 			/* determine the length from the length code */
 			int array_index;
-			array_index = length_value - MIN_LENGTH_CODE;
-			length_value = BASE_LENGTH[array_index];
-			length_value += get_data_element (src, &index, &bit, EXTRA_BITS[array_index]);
+			array_index = s->length_value - MIN_LENGTH_CODE;
+			if (!bits_have (br, LENGTH_EXTRA_BITS[array_index]))
+				return INFLATE_NEED_INPUT;
+			s->length_value = LENGTH_BASE[array_index];
+			s->length_value += bits_get (br, LENGTH_EXTRA_BITS[array_index]);
 
 			/* go to next state */
-			block_state = DECODE_DISTANCE;
+			s->block_state = DECODE_DISTANCE;
 		}
 
-		else if (block_state == DECODE_DISTANCE)
+		else if (s->block_state == DECODE_DISTANCE)
 		{
-			pair* match;
-			pair code;
-
-			/* parse bitwise until a length/literal code is found */
-			match = NULL;
-			code.key = 1; /* 1 is the length indicator bit */
-			while (!match && (code.key < (ULONG_MAX / 2))) {
-				code.key <<= 1;
-				code.key += get_bit (src, &index, &bit);
-				match = bsearch ((void*) &code, (void*) d_tree, hdist, sizeof (d_tree[0]), key_cmp);	
-			}
+			int symbol, bits;
 
+			/* look the next distance code up in the decoding table */
+			symbol = peek_symbol (s->d_decode, DISTANCE_ROOT_BITS, br, &bits);
+			if (symbol == DECODE_NEED_INPUT)
+				return INFLATE_NEED_INPUT;
 
-			/* if no match was found, then the data must be bad */
-			if (!match)
-				return size;
+			/* if no code matched, then the data must be bad */
+			if (symbol < 0 || symbol > MAX_DISTANCE_CODE) {
+				fprintf (stderr, "in comp_inflate(), invalid distance code.\n");
+				return INFLATE_ERROR;
+			}
 
 			/* go to the next state */
-			distance_value = match->value;
-			block_state = READ_DISTANCE_EXTRA_BITS;
+			bits_consume (br, bits);
+			s->distance_value = symbol;
+			s->block_state = READ_DISTANCE_EXTRA_BITS;
 		}
 
-		else if (block_state == READ_DISTANCE_EXTRA_BITS)
+		else if (s->block_state == READ_DISTANCE_EXTRA_BITS)
 		{
-			/* the distance code extra bit table from page 11 of the Deflate spec. */
-			u16 BASE_LENGTH[MAX_DISTANCE_CODE + 1] = {
-				1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
-				513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
-			};
-			u8 EXTRA_BITS[MAX_DISTANCE_CODE + 1] = {
-				0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
-			};
-			
 			/* determine the distance from the table */
 			int d_code;
-			d_code = distance_value;
-			distance_value = BASE_LENGTH[d_code];
-			distance_value += get_data_element (src, &index, &bit, EXTRA_BITS[d_code]);
+			d_code = s->distance_value;
+			if (!bits_have (br, DISTANCE_EXTRA_BITS[d_code]))
+				return INFLATE_NEED_INPUT;
+			s->distance_value = DISTANCE_BASE[d_code];
+			s->distance_value += bits_get (br, DISTANCE_EXTRA_BITS[d_code]);
 	
 			/* go to next state */
-			block_state = COPY_LENGTH_DISTANCE_DATA;
+			s->block_state = COPY_LENGTH_DISTANCE_DATA;
 		}
 
-		else if (block_state == COPY_LENGTH_DISTANCE_DATA)
+		else if (s->block_state == COPY_LENGTH_DISTANCE_DATA)
 		{
-			/* copy length_value bytes from distance_value prior in the destination */
-			for (int i=0; i<length_value; i++)
-				dest[size++] = 'X';
+			/* copy length_value bytes from distance_value prior in the output;
+			   the bounds are checked once for the whole match */
+			if (s->distance_value > s->out_pos) {
+				fprintf (stderr, "in comp_inflate(), distance reaches before start of output.\n");
+				return INFLATE_ERROR;
+			}
+			if (s->length_value > s->out_size - s->out_pos)
+				return INFLATE_NEED_OUTPUT;
+			copy_match (s->out + s->out_pos, s->distance_value, s->length_value);
+			s->out_pos += s->length_value;
 
 			/* go to next state */
-			block_state = DECODE_DATA;
+			s->block_state = DECODE_DATA;
 		}
 	
-		else if (block_state == READ_TREE_METADATA)
+		else if (s->block_state == READ_TREE_METADATA)
 		{
 			/* Read the remainder of the block header for dynamic coding */
-			hlit = 257 + get_data_element (src, &index, &bit, 5);
-			hdist = 1 + get_data_element (src, &index, &bit, 5);
-			hclen = 4 + get_data_element (src, &index, &bit, 4);
-			printf ("READ_TREE_METADATA, hlit=%d, hdist=%d, hclen=%d\n", hlit, hdist, hclen);
-			d_tree = & (contiguous_trees[hlit]);
+			if (!bits_have (br, 14))
+				return INFLATE_NEED_INPUT;
+			s->hlit = 257 + bits_get (br, 5);
+			s->hdist = 1 + bits_get (br, 5);
+			s->hclen = 4 + bits_get (br, 4);
+			TRACE_BLOCK ("READ_TREE_METADATA, hlit=%d, hdist=%d, hclen=%d\n", s->hlit, s->hdist, s->hclen);
 
-			block_state = READ_CODE_LENGTH_CODE_LENGTHS;
+			s->lengths_read = 0;
+			s->block_state = READ_CODE_LENGTH_CODE_LENGTHS;
 		}
 
-		else if (block_state == READ_CODE_LENGTH_CODE_LENGTHS)
+		else if (s->block_state == READ_CODE_LENGTH_CODE_LENGTHS)
 		{
-			/* initialize code length literals in the code length tree */
-			const u16 CL_LITERALS[CODE_LENGTH_TREE_SIZE] = {
+			/* the order code length code lengths are stored in */
+			const u8 CL_LITERALS[CODE_LENGTH_TREE_SIZE] = {
 				16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
 			};
-			for (int i=0; i<CODE_LENGTH_TREE_SIZE; i++) {
-				cl_tree[i].key = 1;
-				cl_tree[i].value = CL_LITERALS[i];
-			}
 
-			/* read code lengths; each is 3 bits */
-			for (int i=0; i<hclen; i++) {
+			/* read code lengths; each is 3 bits, the ones not sent are unused */
+			while (s->lengths_read < CODE_LENGTH_TREE_SIZE) {
 				int code_length;
-				code_length = get_data_element (src, &index, &bit, 3);
-				if (code_length)
-					cl_tree[i].key = 1 << code_length;
+				code_length = 0;
+				if (s->lengths_read < s->hclen) {
+					if (!bits_have (br, 3))
+						return INFLATE_NEED_INPUT;
+					code_length = bits_get (br, 3);
+				}
+				s->cl_lengths[CL_LITERALS[s->lengths_read++]] = code_length;
 			}
 
 			/* go to next state */
-			block_state = BUILD_CODE_LENGTH_CODE_TREE;
+			s->block_state = BUILD_CODE_LENGTH_CODE_TREE;
 		}
 
-		else if (block_state == BUILD_CODE_LENGTH_CODE_TREE)
+		else if (s->block_state == BUILD_CODE_LENGTH_CODE_TREE)
 		{
-			printf ("BUILD_CODE_LENGTH_CODE_TREE\n");
-			/* sort the code trees by code length, then literal value */
-			qsort (cl_tree, CODE_LENGTH_TREE_SIZE, sizeof (cl_tree[0]), pair_cmp);
-
-			/* assign literal/length codes based on code length and order in array */
-			u32 new_code, prev_length_bit;
-			new_code = 0;
-			prev_length_bit = 1;
-			for (int i=0; i<CODE_LENGTH_TREE_SIZE; i++) {
-				/* if the code length bit is 1 or 0, code is not used */
-				if (cl_tree[i].key <= 1)
-					continue;
-				/* if the code length changes, bit shift code by delta length */
-				if (cl_tree[i].key > prev_length_bit) {
-					new_code *= (cl_tree[i].key / prev_length_bit);
-					prev_length_bit = cl_tree[i].key;
-				}
-				cl_tree[i].key |= new_code;
-				new_code++;
-			}
-
-			printf ("Code Length Tree, Code-Value Pairs:\n");
+			TRACE_BLOCK ("BUILD_CODE_LENGTH_CODE_TREE\n");
+			TRACE_DETAIL ("Code Length Code Lengths:\n");
 			for (int i=0; i<CODE_LENGTH_TREE_SIZE; i++)
-				printf ("\t%d\t%d\n", cl_tree[i].key, cl_tree[i].value);
+				TRACE_DETAIL ("\t%d\t%d\n", i, s->cl_lengths[i]);
+
+			if (build_decode_table (s->cl_table, CODE_LENGTH_TABLE_SIZE,
+				CODE_LENGTH_ROOT_BITS, s->cl_lengths, CODE_LENGTH_TREE_SIZE)
+			) {
+				fprintf (stderr, "in comp_inflate(), invalid code length code lengths.\n");
+				return INFLATE_ERROR;
+			}
 		
 			/* go to next state */
-			block_state = READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS;
+			s->lengths_read = 0;
+			s->block_state = READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS;
 		}
 
-		else if (block_state == READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS)
+		else if (s->block_state == READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS)
 		{
-			printf ("READ_LENGTH_LITERAL_AND_DISTANCE_CODE_LENGTHS\n");
-			/* load sequenctial values into the Length/Literal and Distance Trees */
-			initialize_pair_array (ll_tree, LITERAL_LENGTH_TREE_SIZE);
-			initialize_pair_array (d_tree, DISTANCE_TREE_SIZE);
-
-			/* need to read hlit + hdist number of codes */
-			pair* match;
-			pair code;
-			int i = 0;
-			while (i < hlit + hdist)
+			/* need to read hlit + hdist number of codes, which run on from the
+			   literal/length lengths into the distance lengths */
+			int symbol, bits, extra_bits, repeat_length;
+			while (s->lengths_read < s->hlit + s->hdist)
 			{
-				/* parse bitwise until a code length code is found */
-				match = NULL;
-				code.key = 1; /* 1 is the length indicator bit */
-				while (!match && (code.key < (ULONG_MAX / 2))) {
-					code.key <<= 1;
-					code.key += get_bit (src, &index, &bit);
-					match = bsearch ((void*) &code, (void*) cl_tree, CODE_LENGTH_TREE_SIZE, sizeof (cl_tree[0]), key_cmp);	
-				}
+				/* look the next code length code up in the decoding table */
+				symbol = peek_symbol (s->cl_table, CODE_LENGTH_ROOT_BITS, br, &bits);
+				if (symbol == DECODE_NEED_INPUT)
+					return INFLATE_NEED_INPUT;
 	
-				/* if no match was found, then the data must be bad */
-				if (!match) {
+				/* if no code matched, then the data must be bad */
+				if (symbol < 0) {
 					fprintf (stderr, "in comp_inflate(), could not decode dynamic code lengths, no match found.\n");
-					return 0;
+					return INFLATE_ERROR;
 				}
+
+				/* a repeat code and its extra bits are consumed together */
+				extra_bits = (symbol < 16) ? 0 : (symbol == 16) ? 2 : (symbol == 17) ? 3 : 7;
+				if (!bits_have (br, bits + extra_bits))
+					return INFLATE_NEED_INPUT;
+				bits_consume (br, bits);
 	
 				/* take action and choose next state base on the literal/length value */
-				if (match->value < 16) {
-					contiguous_trees[i++].key = 1 << match->value;
+				if (symbol < 16) {
+					s->lengths[s->lengths_read++] = symbol;
+					continue;
 				}
-				else if (match->value == 16) {
-					if (!i) {
+				else if (symbol == 16) {
+					if (!s->lengths_read) {
 						fprintf (stderr, "in comp_inflate(), cannot build dynamic huffman tree;");
 						fprintf (stderr, "repeat code 16 encountered without any prior lengths.\n");
-						return 0;
+						return INFLATE_ERROR;
 					}
-					int repeat_length;
-					repeat_length = 3 + get_data_element (src, &index, &bit, 2);
-					for (int j=0; j<repeat_length; j++) {
-						contiguous_trees[i].key = contiguous_trees[i-1].key;
-						i++;
-					}
-				}
-				else if (match->value == 17) {
-					int repeat_length;
-					repeat_length = 3 + get_data_element (src, &index, &bit, 3);
-					for (int j=0; j<repeat_length; j++)
-						contiguous_trees[i++].key = 1;
+					repeat_length = 3 + bits_get (br, extra_bits);
 				}
-				else {
-					int repeat_length;
-					repeat_length = 11 + get_data_element (src, &index, &bit, 7);
-					for (int j=0; j<repeat_length; j++)
-						contiguous_trees[i++].key = 1;
+				else if (symbol == 17)
+					repeat_length = 3 + bits_get (br, extra_bits);
+				else
+					repeat_length = 11 + bits_get (br, extra_bits);
+
+				/* repeats may not run past the last distance code */
+				if (repeat_length > s->hlit + s->hdist - s->lengths_read) {
+					fprintf (stderr, "in comp_inflate(), code length repeat overflows the code.\n");
+					return INFLATE_ERROR;
 				}
-				
-				/* continue to next literal/length code */
+				memset (s->lengths + s->lengths_read,
+					(symbol == 16) ? s->lengths[s->lengths_read - 1] : 0, repeat_length);
+				s->lengths_read += repeat_length;
 			}	
 
 			/* go to next state */
-			block_state = BUILD_CODE_TREES;
+			s->block_state = BUILD_CODE_TREES;
 		}
 
-		if (index >= src_size)
-			printf ("index exceeds bounds.\n");	
+		if (bits_overrun (br)) {
+			TRACE_ERROR ("index exceeds bounds.\n");
+			return INFLATE_ERROR;
+		}
 		/* otherwise, continue reading the compressed data */
 	}
 
-	return size;
+	return INFLATE_STREAM_END;
 } 
 
-int get_data_element (const u8* data_stream, u32* current_byte, int* current_bit, int number_of_bits) {
+int inflate_fast (struct comp_Stream* s) {
+
+	/* Decode literal/length/distance/copy sequences in a tight loop while at
+	   least INFLATE_FAST_MIN_INPUT bytes of the chunk and MAX_MATCH_LENGTH
+	   bytes of output are left, so that one refill covers a whole sequence
+	   and nothing needs a bounds check. Codes it cannot handle are left
+	   unconsumed, in the matching state, for inflate_blocks() to report. */
+	const u8* in;
+	u32 in_size, index, out_pos, out_limit;
+	u64 buffer;
+	int count;
+	u8* out;
+	const table_entry *ll, *d;
+
+	if (s->out_size < MAX_MATCH_LENGTH)
+		return 0;
+	in = s->br.src;
+	in_size = s->br.src_size;
+	index = s->br.index;
+	buffer = s->br.buffer;
+	count = s->br.count;
+	out = s->out;
+	out_pos = s->out_pos;
+	out_limit = s->out_size - MAX_MATCH_LENGTH;
+	ll = s->ll_decode;
+	d = s->d_decode;
+
+	while (index + INFLATE_FAST_MIN_INPUT <= in_size && out_pos <= out_limit) {
+		table_entry entry;
+		int used, symbol;
+		u32 length, distance;
+
+		/* refill to at least 56 bits, enough for the longest sequence:
+		   15 + 5 bits of length and 15 + 13 bits of distance */
+		const u8* p;
+		p = in + index;
+		buffer |= ((u64) p[0] | ((u64) p[1] << 8) | ((u64) p[2] << 16) | ((u64) p[3] << 24)
+			| ((u64) p[4] << 32) | ((u64) p[5] << 40) | ((u64) p[6] << 48) | ((u64) p[7] << 56)) << count;
+		index += (63 - count) >> 3;
+		count |= BIT_READER_MAX_PEEK;
+
+		/* literal/length code */
+		used = 0;
+		entry = ll[buffer & ((1 << LITERAL_LENGTH_ROOT_BITS) - 1)];
+		if (entry.op == HUFFMAN_OP_SUBTABLE) {
+			used = LITERAL_LENGTH_ROOT_BITS;
+			entry = ll[entry.value + ((buffer >> used) & ((1 << entry.bits) - 1))];
+		}
+		if (entry.op != HUFFMAN_OP_SYMBOL || entry.value > MAX_LENGTH_CODE)
+			break;
+		symbol = entry.value;
+		used += entry.bits;
+		buffer >>= used;
+		count -= used;
+		if (symbol < 256) {
+			out[out_pos++] = symbol;
+			continue;
+		}
+		if (symbol == END_OF_BLOCK) {
+			s->block_state = NEW_BLOCK;
+			break;
+		}
+		symbol -= MIN_LENGTH_CODE;
+		length = LENGTH_BASE[symbol] + (buffer & ((1 << LENGTH_EXTRA_BITS[symbol]) - 1));
+		buffer >>= LENGTH_EXTRA_BITS[symbol];
+		count -= LENGTH_EXTRA_BITS[symbol];
+
+		/* distance code */
+		used = 0;
+		entry = d[buffer & ((1 << DISTANCE_ROOT_BITS) - 1)];
+		if (entry.op == HUFFMAN_OP_SUBTABLE) {
+			used = DISTANCE_ROOT_BITS;
+			entry = d[entry.value + ((buffer >> used) & ((1 << entry.bits) - 1))];
+		}
+		if (entry.op != HUFFMAN_OP_SYMBOL || entry.value > MAX_DISTANCE_CODE) {
+			s->length_value = length;
+			s->block_state = DECODE_DISTANCE;
+			break;
+		}
+		symbol = entry.value;
+		used += entry.bits;
+		buffer >>= used;
+		count -= used;
+		distance = DISTANCE_BASE[symbol] + (buffer & ((1 << DISTANCE_EXTRA_BITS[symbol]) - 1));
+		buffer >>= DISTANCE_EXTRA_BITS[symbol];
+		count -= DISTANCE_EXTRA_BITS[symbol];
+
+		/* the output margin already covers the length */
+		if (distance > out_pos) {
+			fprintf (stderr, "in comp_inflate(), distance reaches before start of output.\n");
+			return INFLATE_ERROR;
+		}
+		copy_match (out + out_pos, distance, length);
+		out_pos += length;
+	}
+
+	/* hand the position back to the careful states */
+	s->br.index = index;
+	s->br.buffer = buffer;
+	s->br.count = count;
+	s->out_pos = out_pos;
+	return 0;
+}
+
+void bits_init (bit_reader* br) {
+	br->src = NULL;
+	br->src_size = 0;
+	br->index = 0;
+	br->buffer = 0;
+	br->count = 0;
+	br->final = 0;
+}
+
+void bits_feed (bit_reader* br, const u8* src, u32 src_size, int final) {
+	/* pending bits of the previous chunk stay in the accumulator */
+	br->src = src;
+	br->src_size = src_size;
+	br->index = 0;
+	br->final = final;
+}
+
+void bits_refill (bit_reader* br) {
 
-	int bit, byte, data_element;
-	data_element = 0;
-	for (int i=0; i<number_of_bits; i++) {
-		byte = data_stream[*current_byte];
-		bit = (byte & (1 << (*current_bit))) >> (*current_bit);
-		data_element += bit << i;
-		(*current_bit)++;
-		(*current_byte) += (*current_bit) / 8;
-		(*current_bit) %= 8;
+	if (br->index + 8 <= br->src_size) {
+		/* load a whole little-endian word; bytes that do not fit are loaded
+		   again by the next refill, into the same bit positions */
+		const u8* p;
+		u64 word;
+		p = br->src + br->index;
+		word = (u64) p[0] | ((u64) p[1] << 8) | ((u64) p[2] << 16) | ((u64) p[3] << 24)
+			| ((u64) p[4] << 32) | ((u64) p[5] << 40) | ((u64) p[6] << 48) | ((u64) p[7] << 56);
+		br->buffer |= word << br->count;
+		br->index += (63 - br->count) >> 3;
+		br->count |= BIT_READER_MAX_PEEK;
 	}
+	else {
+		/* near the end of the chunk, one byte at a time; only the last
+		   chunk is padded with zero bytes */
+		while (br->count <= BIT_READER_MAX_PEEK) {
+			if (br->index < br->src_size)
+				br->buffer |= (u64) br->src[br->index] << br->count;
+			else if (!br->final)
+				break;
+			br->index++;
+			br->count += 8;
+		}
+	}
+}
+
+int bits_have (bit_reader* br, int number_of_bits) {
+	bits_refill (br);
+	return br->count >= number_of_bits;
+}
+
+u32 bits_peek (const bit_reader* br, int number_of_bits) {
+	return br->buffer & ((1ULL << number_of_bits) - 1);
+}
+
+void bits_consume (bit_reader* br, int number_of_bits) {
+	br->buffer >>= number_of_bits;
+	br->count -= number_of_bits;
+}
+
+u32 bits_get (bit_reader* br, int number_of_bits) {
+	u32 data_element;
+	bits_refill (br);
+	data_element = bits_peek (br, number_of_bits);
+	bits_consume (br, number_of_bits);
 	return data_element;
 }
 
-int get_bit (const u8* data_stream, u32* current_byte, int* current_bit) {
-	
-	u8 bit, byte;
-	byte = data_stream[*current_byte];
-	bit = (byte & (1 << (*current_bit))) >> (*current_bit);
-	(*current_bit)++;
-	(*current_byte) += (*current_bit) / 8;
-	(*current_bit) %= 8;
-	return bit;
+void bits_align (bit_reader* br) {
+	/* every loaded byte is whole, so the partial byte is count % 8 bits */
+	bits_consume (br, br->count & 7);
 }
 
-void initialize_pair_array (pair* tree, int size) {
-	for (int i=0; i<size; i++) {
-		tree[i].key = 1;
-		tree[i].value = i;
+int bits_overrun (const bit_reader* br) {
+	/* true once any of the zero padding has been consumed */
+	return br->index > br->src_size && (br->index - br->src_size) * 8 > br->count;
+}
+
+u32 bits_copy_bytes (bit_reader* br, u8* dest, u32 length) {
+
+	/* whole bytes already in the accumulator come first, then the rest is
+	   copied straight from the chunk */
+	u32 copied, n;
+	copied = 0;
+	while (copied < length && br->count >= 8) {
+		dest[copied++] = br->buffer & 0xff;
+		bits_consume (br, 8);
 	}
+	if (copied == length || br->index >= br->src_size)
+		return copied;
+
+	/* the accumulator is empty; forget any bits loaded ahead of index */
+	br->buffer = 0;
+	n = length - copied;
+	if (n > br->src_size - br->index)
+		n = br->src_size - br->index;
+	memcpy (dest + copied, br->src + br->index, n);
+	br->index += n;
+	return copied + n;
 }
 
-int pair_cmp (const void* p1, const void* p2)
-{
-	/* compare the keys */
-	int keys_cmp;
-	keys_cmp = key_cmp (p1, p2);
-	if (keys_cmp)
-		return keys_cmp;
-	else
-	{	
-		/* keys match, so compare values ASCII-alphabetically */
-		u16 val1, val2;
-		val1 = ((pair*) p1)->value;
-		val2 = ((pair*) p2)->value;
-		if (val1 > val2)
-			return 1;
-		else if (val1 < val2)
+int build_decode_table (table_entry* table, int table_size, int root_bits, const u8* lengths, int symbols) {
+
+	/* returns -1 for an over-subscribed or incomplete set of code lengths,
+	   except that a single code of length one is allowed (RFC 1951 3.2.7) */
+	u16 bl_count[MAX_CODE_LENGTH + 1];
+	u16 next_code[MAX_CODE_LENGTH + 1];
+	u8 sub_bits[1 << LITERAL_LENGTH_ROOT_BITS];
+	int root_size, next_sub, max_length, left;
+	u32 code;
+
+	root_size = 1 << root_bits;
+	if (root_size > table_size)
+		return -1;
+
+	/* histogram the code lengths */
+	for (int len=0; len<=MAX_CODE_LENGTH; len++)
+		bl_count[len] = 0;
+	for (int i=0; i<symbols; i++) {
+		if (lengths[i] > MAX_CODE_LENGTH)
+			return -1;
+		bl_count[lengths[i]]++;
+	}
+	bl_count[0] = 0;
+
+	/* check the Kraft sum: left counts the unused codes at each length */
+	left = 1;
+	max_length = 0;
+	for (int len=1; len<=MAX_CODE_LENGTH; len++) {
+		left <<= 1;
+		left -= bl_count[len];
+		if (left < 0)
+			return -1;
+		if (bl_count[len])
+			max_length = len;
+	}
+	if (left > 0 && max_length > 1)
+		return -1;
+
+	/* first code of each length, page 8 of the Spec. */
+	code = 0;
+	next_code[0] = 0;
+	for (int len=1; len<=MAX_CODE_LENGTH; len++) {
+		code = (code + bl_count[len-1]) << 1;
+		next_code[len] = code;
+	}
+
+	/* unused codes decode as invalid */
+	for (int i=0; i<root_size; i++) {
+		table[i].op = HUFFMAN_OP_INVALID;
+		table[i].bits = root_bits;
+		table[i].value = 0;
+		sub_bits[i] = 0;
+	}
+
+	/* replicate the short codes into the primary table and measure the
+	   sub-table width needed under each prefix of the long codes */
+	for (int i=0; i<symbols; i++) {
+		int len;
+		len = lengths[i];
+		if (!len)
+			continue;
+		code = next_code[len]++;
+		if (len <= root_bits) {
+			for (u32 j = reverse_bits (code, len); j < root_size; j += (1 << len)) {
+				table[j].op = HUFFMAN_OP_SYMBOL;
+				table[j].bits = len;
+				table[j].value = i;
+			}
+		}
+		else {
+			u32 prefix;
+			prefix = reverse_bits (code >> (len - root_bits), root_bits);
+			if (sub_bits[prefix] < len - root_bits)
+				sub_bits[prefix] = len - root_bits;
+		}
+	}
+	if (max_length <= root_bits)
+		return 0;
+
+	/* lay out the sub-tables after the primary table */
+	next_sub = root_size;
+	for (int i=0; i<root_size; i++) {
+		if (!sub_bits[i])
+			continue;
+		if (next_sub + (1 << sub_bits[i]) > table_size)
 			return -1;
-		else
-			return 0;
+		table[i].op = HUFFMAN_OP_SUBTABLE;
+		table[i].bits = sub_bits[i];
+		table[i].value = next_sub;
+		next_sub += 1 << sub_bits[i];
+	}
+
+	/* fill the sub-tables with the long codes, assigned again from the
+	   first long code of each length */
+	code = 0;
+	for (int len=1; len<=MAX_CODE_LENGTH; len++) {
+		code = (code + bl_count[len-1]) << 1;
+		next_code[len] = code;
 	}
+	for (int i=0; i<symbols; i++) {
+		int len, width;
+		u32 reversed;
+		table_entry* sub;
+		len = lengths[i];
+		if (!len)
+			continue;
+		code = next_code[len]++;
+		if (len <= root_bits)
+			continue;
+		reversed = reverse_bits (code, len);
+		sub = table + table[reversed & (root_size - 1)].value;
+		width = table[reversed & (root_size - 1)].bits;
+		for (u32 j = reversed >> root_bits; j < (1 << width); j += (1 << (len - root_bits))) {
+			sub[j].op = HUFFMAN_OP_SYMBOL;
+			sub[j].bits = len - root_bits;
+			sub[j].value = i;
+		}
+	}
+	return 0;
 }
 
-int key_cmp (const void* p1, const void* p2)
-{
-	/* make local copies of the keys */
-	u32 key1, key2;
-	key1 = ((pair*) p1)->key;
-	key2 = ((pair*) p2)->key;
-	
-	/* compare keys */
+int peek_symbol (const table_entry* table, int root_bits, bit_reader* br, int* bits) {
+
+	/* one probe for codes up to root_bits long, two for longer codes; the
+	   code is not consumed, its length is returned in bits */
+	table_entry entry;
+	int used;
+	bits_refill (br);
+	used = 0;
+	entry = table[bits_peek (br, root_bits)];
+	if (entry.op == HUFFMAN_OP_SUBTABLE) {
+		used = root_bits;
+		entry = table[entry.value + ((br->buffer >> root_bits) & ((1 << entry.bits) - 1))];
+	}
+
+	/* past the pending bits the code may just be incomplete */
+	if (entry.op != HUFFMAN_OP_SYMBOL)
+		return (br->count < MAX_CODE_LENGTH) ? DECODE_NEED_INPUT : DECODE_INVALID;
+	*bits = used + entry.bits;
+	if (*bits > br->count)
+		return DECODE_NEED_INPUT;
+	return entry.value;
+}
+
+void copy_match (u8* out, u32 distance, u32 length) {
+
+	const u8* from;
+	from = out - distance;
+
+	/* a distance of one is a run of a single byte */
+	if (distance == 1) {
+		memset (out, *from, length);
+		return;
+	}
+
+	/* short distances: replicate the pattern in place, doubling it each
+	   time, until it is wide enough for word copies. The gap between from
+	   and out stays a multiple of the distance, so the copies continue the
+	   same pattern. */
+	if (distance < 8) {
+		u32 gap;
+		gap = distance;
+		while (gap < 8 && length) {
+			u32 n;
+			n = (gap < length) ? gap : length;
+			memcpy (out, out - gap, n);
+			out += n;
+			length -= n;
+			gap += n;
+		}
+		from = out - gap;
+		distance = gap;
+	}
+
+	/* the source of each chunk lies entirely before its destination */
+	if (distance >= 16) {
+		while (length >= 16) {
+			memcpy (out, from, 16);
+			out += 16;
+			from += 16;
+			length -= 16;
+		}
+	}
+	while (length >= 8) {
+		memcpy (out, from, 8);
+		out += 8;
+		from += 8;
+		length -= 8;
+	}
+	while (length--)
+		*out++ = *from++;
+}
+
+u32 reverse_bits (u32 code, int length) {
+	u32 reversed;
+	reversed = 0;
+	for (int i=0; i<length; i++) {
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	return reversed;
+}
+
+/* The compressor finds matches through hash chains over the last 32 KiB,
+   collects up to DEFLATE_BLOCK_SYMBOLS literals and matches, and then emits
+   them as whichever of a stored, fixed or dynamic block is smallest. */
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_HASH_SIZE (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_TOO_FAR 4096		/* lazy levels drop 3-byte matches further away */
+#define DEFLATE_BLOCK_SYMBOLS 16384
+#define DEFLATE_MAX_STORED 65535
+#define DEFLATE_LENGTH_CODES (MAX_LENGTH_CODE - MIN_LENGTH_CODE + 1)
+#define DEFLATE_DISTANCE_CODES (MAX_DISTANCE_CODE + 1)
+#define DEFLATE_LITERAL_LENGTH_CODES (MAX_LENGTH_CODE + 1)
+#define MAX_CODE_LENGTH_CODE_LENGTH 7
+
+typedef struct deflate_symbol lz_symbol;
+struct deflate_symbol {
+	u16 literal_length;	/* literal byte, or match length */
+	u16 distance;		/* 0 for a literal */
+};
+
+typedef struct deflate_level_config level_config;
+struct deflate_level_config {
+	u16 good_length;	/* lazy: search less once the previous match is this long */
+	u16 max_lazy;		/* greedy: longest match whose positions are all hashed;
+						   lazy: no search for a better match after one this long */
+	u16 nice_length;	/* stop searching once a match is this long */
+	u16 max_chain;		/* hash chain links to follow */
+};
+
+/* levels 1-3 take the first match found, 4-9 defer to a longer one at the
+   next position; the values are zlib's */
+#define DEFLATE_LAZY_MIN_LEVEL 4
+static const level_config LEVEL_CONFIG[COMP_DEFLATE_BEST + 1] = {
+	{0, 0, 0, 0},
+	{4, 4, 8, 4},
+	{4, 5, 16, 8},
+	{4, 6, 32, 32},
+	{4, 4, 16, 16},
+	{8, 16, 32, 32},
+	{8, 16, 128, 128},
+	{8, 32, 128, 256},
+	{32, 128, 258, 1024},
+	{32, 258, 258, 4096}
+};
+
+struct deflate_state {
+	const u8* src;
+	u32 src_size;
+	bit_writer bw;
+	const level_config* config;
+	int* head;				/* latest position for each hash, or -1 */
+	int* prev;				/* previous position with the same hash */
+	lz_symbol* symbols;
+	u32 symbol_count;
+	u32 block_start;		/* first src byte of the current block */
+	u32 covered;			/* src bytes covered by the recorded symbols */
+	u32 ll_freq[LITERAL_LENGTH_TREE_SIZE];
+	u32 d_freq[DISTANCE_TREE_SIZE];
+	u8 length_code[MAX_MATCH_LENGTH + 1];
+	u8 distance_code[512];	/* see deflate_distance_code() */
+};
+
+void deflate_init_codes (struct deflate_state*);
+u32 deflate_hash (const u8*);
+void deflate_insert (struct deflate_state*, u32);
+u32 deflate_longest_match (struct deflate_state*, u32, u32, u32*);
+/* state, position, length to beat, distance found */
+int deflate_distance_code (const struct deflate_state*, u32);
+void deflate_record (struct deflate_state*, u32, u32);
+/* state, literal or length, distance (0 for a literal) */
+void deflate_greedy (struct deflate_state*);
+void deflate_lazy (struct deflate_state*);
+void deflate_flush_block (struct deflate_state*, int);
+void deflate_stored (bit_writer*, const u8*, u32, int);
+/* bit writer, data, size, last block */
+void build_code_lengths (const u32*, int, int, u8*);
+/* frequencies, number of symbols, length limit, code lengths */
+void build_codes (const u8*, int, u16*);
+/* code lengths, number of symbols, bit-reversed codes */
+int u64_cmp (const void*, const void*);
+
+int comp_deflate (u8* dest, int dest_size, const u8* src, int src_size, int level) {
+
+	struct deflate_state* s;
+	if (level < COMP_DEFLATE_STORED || level > COMP_DEFLATE_BEST)
+		level = COMP_DEFLATE_DEFAULT;
+
+	/* level 0 only wraps the data in stored blocks */
+	if (level == COMP_DEFLATE_STORED) {
+		bit_writer bw;
+		bits_writer_init (&bw, dest, dest_size);
+		deflate_stored (&bw, src, src_size, 1);
+		bits_flush (&bw);
+		return (bw.index > dest_size) ? -1 : (int) bw.index;
+	}
+
+	/* allocate the state and the match finder in memory */
+	s = malloc (sizeof (struct deflate_state));
+	if (!s)
+		printf ("memory allocation failure\n"), exit (EXIT_FAILURE);
+	s->head = malloc (DEFLATE_HASH_SIZE * sizeof (int));
+	s->prev = malloc (COMP_WINDOW_SIZE * sizeof (int));
+	s->symbols = malloc (DEFLATE_BLOCK_SYMBOLS * sizeof (lz_symbol));
+	if (!s->head || !s->prev || !s->symbols)
+		printf ("memory allocation failure\n"), exit (EXIT_FAILURE);
+
+	/* initialize variables */
+	s->src = src;
+	s->src_size = src_size;
+	bits_writer_init (&s->bw, dest, dest_size);
+	s->config = &LEVEL_CONFIG[level];
+	for (int i=0; i<DEFLATE_HASH_SIZE; i++)
+		s->head[i] = -1;
+	s->symbol_count = 0;
+	s->block_start = 0;
+	s->covered = 0;
+	memset (s->ll_freq, 0, sizeof (s->ll_freq));
+	memset (s->d_freq, 0, sizeof (s->d_freq));
+	deflate_init_codes (s);
+
+	/* find the matches, flushing blocks as the symbol buffer fills */
+	if (level < DEFLATE_LAZY_MIN_LEVEL)
+		deflate_greedy (s);
+	else
+		deflate_lazy (s);
+	deflate_flush_block (s, 1);
+	bits_flush (&s->bw);
+
+	int size;
+	size = (s->bw.index > dest_size) ? -1 : (int) s->bw.index;
+	free (s->head);
+	free (s->prev);
+	free (s->symbols);
+	free (s);
+	return size;
+}
+
+int comp_deflate_bound (int src_size) {
+	/* the worst case is every block stored: a 5 byte header for each
+	   stored chunk, and a chunk boundary at every symbol buffer flush */
+	long long bound;
+	bound = src_size + 5LL * (src_size / (DEFLATE_BLOCK_SYMBOLS) + src_size / DEFLATE_MAX_STORED + 2) + 8;
+	return (bound > INT_MAX) ? -1 : (int) bound;
+}
+
+void deflate_init_codes (struct deflate_state* s) {
+	/* map lengths and distances to their codes, reading page 11 of the
+	   Spec. backwards */
+	for (int c=0; c<DEFLATE_LENGTH_CODES; c++)
+		for (int len = LENGTH_BASE[c]; len <= MAX_MATCH_LENGTH && len < LENGTH_BASE[c] + (1 << LENGTH_EXTRA_BITS[c]); len++)
+			s->length_code[len] = c;
+	s->length_code[MAX_MATCH_LENGTH] = DEFLATE_LENGTH_CODES - 1;
+	for (int c=0; c<DEFLATE_DISTANCE_CODES; c++)
+		for (u32 d = DISTANCE_BASE[c]; d < DISTANCE_BASE[c] + (1 << DISTANCE_EXTRA_BITS[c]); d++) {
+			if (d - 1 < 256)
+				s->distance_code[d - 1] = c;
+			else
+				s->distance_code[256 + ((d - 1) >> 7)] = c;
+		}
+}
+
+int deflate_distance_code (const struct deflate_state* s, u32 distance) {
+	/* distances above 256 share a code with their neighbours in groups of
+	   128, which is finer than any code above 256 */
+	if (distance - 1 < 256)
+		return s->distance_code[distance - 1];
+	return s->distance_code[256 + ((distance - 1) >> 7)];
+}
+
+u32 deflate_hash (const u8* p) {
+	u32 key;
+	key = ((u32) p[0] << 16) | ((u32) p[1] << 8) | p[2];
+	return ((key * 2654435761UL) & 0xffffffffUL) >> (32 - DEFLATE_HASH_BITS);
+}
+
+void deflate_insert (struct deflate_state* s, u32 pos) {
+	u32 hash;
+	hash = deflate_hash (s->src + pos);
+	s->prev[pos & (COMP_WINDOW_SIZE - 1)] = s->head[hash];
+	s->head[hash] = pos;
+}
+
+u32 deflate_longest_match (struct deflate_state* s, u32 pos, u32 prev_length, u32* distance) {
+
+	/* pos must already be inserted; returns 0 unless a match longer than
+	   prev_length is found */
+	u32 best, max_length, nice, chain;
+	int cur, next;
+	const u8 *a, *b;
+
+	max_length = s->src_size - pos;
+	if (max_length > MAX_MATCH_LENGTH)
+		max_length = MAX_MATCH_LENGTH;
+	if (max_length <= prev_length)
+		return 0;
+	nice = (s->config->nice_length < max_length) ? s->config->nice_length : max_length;
+	chain = s->config->max_chain;
+	if (prev_length >= s->config->good_length)
+		chain >>= 2;
+
+	best = prev_length;
+	b = s->src + pos;
+	cur = s->prev[pos & (COMP_WINDOW_SIZE - 1)];
+	while (cur >= 0 && chain--) {
+		if (pos - cur > COMP_WINDOW_SIZE)
+			break;
+		a = s->src + cur;
+
+		/* cheap rejects before the full comparison */
+		if (a[best] == b[best] && a[0] == b[0] && a[1] == b[1]) {
+			u32 len;
+			u64 x, y;
+			len = 2;
+			while (len + 8 <= max_length) {
+				memcpy (&x, a + len, 8);
+				memcpy (&y, b + len, 8);
+				if (x != y)
+					break;
+				len += 8;
+			}
+			while (len < max_length && a[len] == b[len])
+				len++;
+			if (len > best) {
+				best = len;
+				*distance = pos - cur;
+				if (len >= nice)
+					break;
+			}
+		}
+
+		/* a slot overwritten by a newer position ends the chain */
+		next = s->prev[cur & (COMP_WINDOW_SIZE - 1)];
+		if (next >= cur)
+			break;
+		cur = next;
+	}
+	return (best > prev_length) ? best : 0;
+}
+
+void deflate_record (struct deflate_state* s, u32 literal_length, u32 distance) {
+
+	s->symbols[s->symbol_count].literal_length = literal_length;
+	s->symbols[s->symbol_count].distance = distance;
+	s->symbol_count++;
+	if (!distance) {
+		s->ll_freq[literal_length]++;
+		s->covered++;
+	}
+	else {
+		s->ll_freq[MIN_LENGTH_CODE + s->length_code[literal_length]]++;
+		s->d_freq[deflate_distance_code (s, distance)]++;
+		s->covered += literal_length;
+	}
+	if (s->symbol_count == DEFLATE_BLOCK_SYMBOLS)
+		deflate_flush_block (s, 0);
+}
+
+void deflate_greedy (struct deflate_state* s) {
+
+	u32 pos, length, distance;
+	pos = 0;
+	while (pos < s->src_size) {
+		length = 0;
+		if (pos + DEFLATE_MIN_MATCH <= s->src_size) {
+			deflate_insert (s, pos);
+			length = deflate_longest_match (s, pos, DEFLATE_MIN_MATCH - 1, &distance);
+		}
+		if (length) {
+			deflate_record (s, length, distance);
+			/* only hash the positions inside short matches */
+			if (length <= s->config->max_lazy)
+				for (u32 i = pos + 1; i < pos + length && i + DEFLATE_MIN_MATCH <= s->src_size; i++)
+					deflate_insert (s, i);
+			pos += length;
+		}
+		else {
+			deflate_record (s, s->src[pos], 0);
+			pos++;
+		}
+	}
+}
+
+void deflate_lazy (struct deflate_state* s) {
+
+	/* a match found at pos - 1 is only taken if pos has no longer one */
+	u32 pos, prev_length, prev_distance, length, distance;
+	int match_available;
+	pos = 0;
+	prev_length = 0;
+	prev_distance = 0;
+	match_available = 0;
+	while (pos < s->src_size) {
+		length = 0;
+		if (pos + DEFLATE_MIN_MATCH <= s->src_size) {
+			deflate_insert (s, pos);
+			if (prev_length < s->config->max_lazy) {
+				length = deflate_longest_match (s, pos,
+					(prev_length > DEFLATE_MIN_MATCH - 1) ? prev_length : DEFLATE_MIN_MATCH - 1, &distance);
+				if (length == DEFLATE_MIN_MATCH && distance > DEFLATE_TOO_FAR)
+					length = 0;
+			}
+		}
+
+		if (prev_length >= DEFLATE_MIN_MATCH && length <= prev_length) {
+			/* the previous match wins; hash the rest of it and skip past it */
+			u32 end;
+			end = pos - 1 + prev_length;
+			deflate_record (s, prev_length, prev_distance);
+			for (u32 i = pos + 1; i < end && i + DEFLATE_MIN_MATCH <= s->src_size; i++)
+				deflate_insert (s, i);
+			pos = end;
+			match_available = 0;
+			prev_length = 0;
+		}
+		else {
+			/* the byte before pos becomes a literal, pos may start a match */
+			if (match_available)
+				deflate_record (s, s->src[pos - 1], 0);
+			match_available = 1;
+			prev_length = length;
+			prev_distance = distance;
+			pos++;
+		}
+	}
+	if (match_available)
+		deflate_record (s, s->src[pos - 1], 0);
+}
+
+void deflate_flush_block (struct deflate_state* s, int last) {
+
+	u8 ll_len[LITERAL_LENGTH_TREE_SIZE], d_len[DISTANCE_TREE_SIZE], cl_len[CODE_LENGTH_TREE_SIZE];
+	u16 ll_code[LITERAL_LENGTH_TREE_SIZE], d_code[DISTANCE_TREE_SIZE], cl_code[CODE_LENGTH_TREE_SIZE];
+	u8 lengths[LITERAL_LENGTH_TREE_SIZE + DISTANCE_TREE_SIZE];
+	u8 cl_symbols[LITERAL_LENGTH_TREE_SIZE + DISTANCE_TREE_SIZE];
+	u8 cl_extra[LITERAL_LENGTH_TREE_SIZE + DISTANCE_TREE_SIZE];
+	u32 cl_freq[CODE_LENGTH_TREE_SIZE];
+	int hlit, hdist, hclen, cl_count, used;
+	u32 block_length, extra_bits, dynamic_bits, fixed_bits, stored_bits;
+	const u8 CL_LITERALS[CODE_LENGTH_TREE_SIZE] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	block_length = s->covered - s->block_start;
+	s->ll_freq[END_OF_BLOCK]++;
+
+	/* complete codes need at least two symbols; the extras are never sent */
+	used = 0;
+	for (int i=0; i<DEFLATE_LITERAL_LENGTH_CODES; i++)
+		used += (s->ll_freq[i] != 0);
+	if (used < 2)
+		s->ll_freq[s->ll_freq[0] ? 1 : 0]++;
+	used = 0;
+	for (int i=0; i<DEFLATE_DISTANCE_CODES; i++)
+		used += (s->d_freq[i] != 0);
+	for (int i=0; used < 2; i++)
+		if (!s->d_freq[i])
+			s->d_freq[i]++, used++;
+
+	build_code_lengths (s->ll_freq, DEFLATE_LITERAL_LENGTH_CODES, MAX_CODE_LENGTH, ll_len);
+	build_code_lengths (s->d_freq, DEFLATE_DISTANCE_CODES, MAX_CODE_LENGTH, d_len);
+	for (hlit = DEFLATE_LITERAL_LENGTH_CODES; hlit > 257 && !ll_len[hlit - 1]; hlit--)
+		;
+	for (hdist = DEFLATE_DISTANCE_CODES; hdist > 1 && !d_len[hdist - 1]; hdist--)
+		;
+	memcpy (lengths, ll_len, hlit);
+	memcpy (lengths + hlit, d_len, hdist);
+
+	/* run-length encode the code lengths with codes 16, 17 and 18 */
+	cl_count = 0;
+	for (int i=0; i < hlit + hdist; ) {
+		int run;
+		for (run = 1; i + run < hlit + hdist && lengths[i + run] == lengths[i]; run++)
+			;
+		if (!lengths[i] && run >= 3) {
+			int n;
+			n = (run > 138) ? 138 : run;
+			cl_symbols[cl_count] = (n >= 11) ? 18 : 17;
+			cl_extra[cl_count++] = (n >= 11) ? n - 11 : n - 3;
+			i += n;
+		}
+		else if (lengths[i] && run >= 4) {
+			int n;
+			n = (run - 1 > 6) ? 6 : run - 1;
+			cl_symbols[cl_count] = lengths[i];
+			cl_extra[cl_count++] = 0;
+			cl_symbols[cl_count] = 16;
+			cl_extra[cl_count++] = n - 3;
+			i += 1 + n;
+		}
+		else {
+			cl_symbols[cl_count] = lengths[i];
+			cl_extra[cl_count++] = 0;
+			i++;
+		}
+	}
+	memset (cl_freq, 0, sizeof (cl_freq));
+	for (int i=0; i<cl_count; i++)
+		cl_freq[cl_symbols[i]]++;
+	build_code_lengths (cl_freq, CODE_LENGTH_TREE_SIZE, MAX_CODE_LENGTH_CODE_LENGTH, cl_len);
+	for (hclen = CODE_LENGTH_TREE_SIZE; hclen > 4 && !cl_len[CL_LITERALS[hclen - 1]]; hclen--)
+		;
+
+	/* size the block each way */
+	extra_bits = 0;
+	for (int c=0; c<DEFLATE_LENGTH_CODES; c++)
+		extra_bits += s->ll_freq[MIN_LENGTH_CODE + c] * LENGTH_EXTRA_BITS[c];
+	for (int c=0; c<DEFLATE_DISTANCE_CODES; c++)
+		extra_bits += s->d_freq[c] * DISTANCE_EXTRA_BITS[c];
+	dynamic_bits = 3 + 5 + 5 + 4 + 3 * hclen + extra_bits;
+	for (int i=0; i<cl_count; i++)
+		dynamic_bits += cl_len[cl_symbols[i]] + ((cl_symbols[i] == 16) ? 2 : (cl_symbols[i] == 17) ? 3 : (cl_symbols[i] == 18) ? 7 : 0);
+	fixed_bits = 3 + extra_bits;
+	for (int i=0; i<DEFLATE_LITERAL_LENGTH_CODES; i++) {
+		dynamic_bits += s->ll_freq[i] * ll_len[i];
+		fixed_bits += s->ll_freq[i] * ((i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8);
+	}
+	for (int i=0; i<DEFLATE_DISTANCE_CODES; i++) {
+		dynamic_bits += s->d_freq[i] * d_len[i];
+		fixed_bits += s->d_freq[i] * 5;
+	}
+	stored_bits = 8 * (block_length + 5 * (block_length / DEFLATE_MAX_STORED + 1));
+
+	/* emit the smallest */
+	if (stored_bits <= fixed_bits && stored_bits <= dynamic_bits)
+		deflate_stored (&s->bw, s->src + s->block_start, block_length, last);
+	else {
+		if (fixed_bits <= dynamic_bits) {
+			for (int i=0; i<LITERAL_LENGTH_TREE_SIZE; i++)
+				ll_len[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+			for (int i=0; i<DISTANCE_TREE_SIZE; i++)
+				d_len[i] = 5;
+			bits_put (&s->bw, last, 1);
+			bits_put (&s->bw, 1, 2);
+			build_codes (ll_len, LITERAL_LENGTH_TREE_SIZE, ll_code);
+			build_codes (d_len, DISTANCE_TREE_SIZE, d_code);
+		}
+		else {
+			bits_put (&s->bw, last, 1);
+			bits_put (&s->bw, 2, 2);
+			bits_put (&s->bw, hlit - 257, 5);
+			bits_put (&s->bw, hdist - 1, 5);
+			bits_put (&s->bw, hclen - 4, 4);
+			for (int i=0; i<hclen; i++)
+				bits_put (&s->bw, cl_len[CL_LITERALS[i]], 3);
+			build_codes (cl_len, CODE_LENGTH_TREE_SIZE, cl_code);
+			for (int i=0; i<cl_count; i++) {
+				int sym;
+				sym = cl_symbols[i];
+				bits_put (&s->bw, cl_code[sym], cl_len[sym]);
+				if (sym >= 16)
+					bits_put (&s->bw, cl_extra[i], (sym == 16) ? 2 : (sym == 17) ? 3 : 7);
+			}
+			build_codes (ll_len, DEFLATE_LITERAL_LENGTH_CODES, ll_code);
+			build_codes (d_len, DEFLATE_DISTANCE_CODES, d_code);
+		}
+
+		/* the symbols themselves */
+		for (u32 i=0; i<s->symbol_count; i++) {
+			u32 value, distance;
+			int c;
+			value = s->symbols[i].literal_length;
+			distance = s->symbols[i].distance;
+			if (!distance) {
+				bits_put (&s->bw, ll_code[value], ll_len[value]);
+				continue;
+			}
+			c = s->length_code[value];
+			bits_put (&s->bw, ll_code[MIN_LENGTH_CODE + c], ll_len[MIN_LENGTH_CODE + c]);
+			bits_put (&s->bw, value - LENGTH_BASE[c], LENGTH_EXTRA_BITS[c]);
+			c = deflate_distance_code (s, distance);
+			bits_put (&s->bw, d_code[c], d_len[c]);
+			bits_put (&s->bw, distance - DISTANCE_BASE[c], DISTANCE_EXTRA_BITS[c]);
+		}
+		bits_put (&s->bw, ll_code[END_OF_BLOCK], ll_len[END_OF_BLOCK]);
+	}
+
+	/* start the next block */
+	s->symbol_count = 0;
+	s->block_start = s->covered;
+	memset (s->ll_freq, 0, sizeof (s->ll_freq));
+	memset (s->d_freq, 0, sizeof (s->d_freq));
+}
+
+void deflate_stored (bit_writer* bw, const u8* data, u32 size, int last) {
+
+	/* at least one block, even for no data */
+	do {
+		u32 n;
+		n = (size > DEFLATE_MAX_STORED) ? DEFLATE_MAX_STORED : size;
+		bits_put (bw, last && n == size, 1);
+		bits_put (bw, 0, 2);
+		bits_flush (bw);
+		bits_put (bw, n, 16);
+		bits_put (bw, ~n & 0xffff, 16);
+		if (bw->index + n <= bw->dest_size)
+			memcpy (bw->dest + bw->index, data, n);
+		bw->index += n;
+		data += n;
+		size -= n;
+	} while (size);
+}
+
+void build_code_lengths (const u32* freq, int symbols, int limit, u8* lengths) {
+
+	/* Huffman's algorithm with two queues over the leaves sorted by weight;
+	   while the code is too deep, the weights are halved and it is rebuilt */
+	u64 order[LITERAL_LENGTH_TREE_SIZE];
+	u32 weight[2 * LITERAL_LENGTH_TREE_SIZE];
+	int parent[2 * LITERAL_LENGTH_TREE_SIZE];
+	int depth[2 * LITERAL_LENGTH_TREE_SIZE];
+
+	for (int shift=0; ; shift++) {
+		int leaves, nodes, leaf, internal, max_depth;
+
+		leaves = 0;
+		for (int i=0; i<symbols; i++) {
+			lengths[i] = 0;
+			if (freq[i]) {
+				u32 w;
+				w = (freq[i] >> shift) ? (freq[i] >> shift) : 1;
+				order[leaves++] = ((u64) w << 16) | i;
+			}
+		}
+		if (!leaves)
+			return;
+		if (leaves == 1) {
+			lengths[order[0] & 0xffff] = 1;
+			return;
+		}
+		qsort (order, leaves, sizeof (order[0]), u64_cmp);
+		for (int i=0; i<leaves; i++)
+			weight[i] = order[i] >> 16;
+
+		/* the new internal nodes come out in increasing weight order */
+		leaf = 0;
+		internal = leaves;
+		for (nodes = leaves; nodes < 2 * leaves - 1; nodes++) {
+			int a, b;
+			a = (leaf < leaves && (internal >= nodes || weight[leaf] <= weight[internal])) ? leaf++ : internal++;
+			b = (leaf < leaves && (internal >= nodes || weight[leaf] <= weight[internal])) ? leaf++ : internal++;
+			weight[nodes] = weight[a] + weight[b];
+			parent[a] = nodes;
+			parent[b] = nodes;
+		}
+
+		/* the root is the last node; every parent comes after its children */
+		depth[nodes - 1] = 0;
+		max_depth = 0;
+		for (int i = nodes - 2; i >= 0; i--) {
+			depth[i] = depth[parent[i]] + 1;
+			if (i < leaves && depth[i] > max_depth)
+				max_depth = depth[i];
+		}
+		if (max_depth <= limit) {
+			for (int i=0; i<leaves; i++)
+				lengths[order[i] & 0xffff] = depth[i];
+			return;
+		}
+	}
+}
+
+void build_codes (const u8* lengths, int symbols, u16* codes) {
+
+	/* canonical codes, page 8 of the Spec., bit-reversed for bits_put() */
+	u16 bl_count[MAX_CODE_LENGTH + 1];
+	u16 next_code[MAX_CODE_LENGTH + 1];
+	u32 code;
+	memset (bl_count, 0, sizeof (bl_count));
+	for (int i=0; i<symbols; i++)
+		bl_count[lengths[i]]++;
+	bl_count[0] = 0;
+	code = 0;
+	for (int len=1; len<=MAX_CODE_LENGTH; len++) {
+		code = (code + bl_count[len-1]) << 1;
+		next_code[len] = code;
+	}
+	for (int i=0; i<symbols; i++)
+		codes[i] = lengths[i] ? reverse_bits (next_code[lengths[i]]++, lengths[i]) : 0;
+}
+
+int u64_cmp (const void* p1, const void* p2) {
+	u64 key1, key2;
+	key1 = *(const u64*) p1;
+	key2 = *(const u64*) p2;
 	if (key1 < key2)
 		return -1;
 	else if (key1 > key2)
@@ -489,3 +2090,153 @@ int key_cmp (const void* p1, const void* p2)
 		return 0;
 }
 
+void bits_writer_init (bit_writer* bw, u8* dest, u32 dest_size) {
+	bw->dest = dest;
+	bw->dest_size = dest_size;
+	bw->index = 0;
+	bw->buffer = 0;
+	bw->count = 0;
+}
+
+void bits_put (bit_writer* bw, u32 value, int number_of_bits) {
+	bw->buffer |= (u64) value << bw->count;
+	bw->count += number_of_bits;
+	if (bw->count >= 32) {
+		if (bw->index + 4 <= bw->dest_size) {
+			bw->dest[bw->index] = bw->buffer;
+			bw->dest[bw->index + 1] = bw->buffer >> 8;
+			bw->dest[bw->index + 2] = bw->buffer >> 16;
+			bw->dest[bw->index + 3] = bw->buffer >> 24;
+		}
+		bw->index += 4;
+		bw->buffer >>= 32;
+		bw->count -= 32;
+	}
+}
+
+void bits_flush (bit_writer* bw) {
+	while (bw->count > 0) {
+		if (bw->index < bw->dest_size)
+			bw->dest[bw->index] = bw->buffer;
+		bw->index++;
+		bw->buffer >>= 8;
+		bw->count -= 8;
+	}
+	bw->buffer = 0;
+	bw->count = 0;
+}
+
+u32 comp_crc32 (u32 crc, const u8* data, int size) {
+
+	/* the CRC-32 of ISO 3309 used by zip; folding with carry-less multiplies
+	   takes whole 16 byte blocks of long data where the processor has them */
+	crc = ~crc & 0xffffffffUL;
+#ifdef COMP_HAVE_PCLMUL
+	if (size >= CRC32_FOLD_MINIMUM && __builtin_cpu_supports ("pclmul") && __builtin_cpu_supports ("sse4.1")) {
+		int blocks;
+		blocks = size & ~15;
+		crc = crc32_fold (crc, data, blocks);
+		data += blocks;
+		size -= blocks;
+	}
+#endif
+	return ~crc32_slice (crc, data, size) & 0xffffffffUL;
+}
+
+u32 crc32_slice (u32 crc, const u8* data, int size) {
+
+	/* eight bytes per step, one table row for each byte; the words are
+	   assembled a byte at a time so that byte order does not matter */
+	while (size >= 8) {
+		u32 one, two;
+		one = crc ^ ((u32) data[0] | (u32) data[1] << 8 | (u32) data[2] << 16 | (u32) data[3] << 24);
+		two = (u32) data[4] | (u32) data[5] << 8 | (u32) data[6] << 16 | (u32) data[7] << 24;
+		crc = CRC32_TABLE[7][one & 0xff] ^ CRC32_TABLE[6][(one >> 8) & 0xff]
+			^ CRC32_TABLE[5][(one >> 16) & 0xff] ^ CRC32_TABLE[4][(one >> 24) & 0xff]
+			^ CRC32_TABLE[3][two & 0xff] ^ CRC32_TABLE[2][(two >> 8) & 0xff]
+			^ CRC32_TABLE[1][(two >> 16) & 0xff] ^ CRC32_TABLE[0][(two >> 24) & 0xff];
+		data += 8;
+		size -= 8;
+	}
+	while (size-- > 0)
+		crc = CRC32_TABLE[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef COMP_HAVE_PCLMUL
+__attribute__ ((target ("pclmul,sse4.1")))
+u32 crc32_fold (u32 crc, const u8* data, int size) {
+
+	/* Fold four 128 bit lanes across the data 64 bytes at a time, then fold
+	   the lanes into one and Barrett reduce it to 32 bits, following Gopal
+	   et al., "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+	   Instruction" (Intel, 2009). The constants are powers of x modulo the
+	   bit-reflected polynomial. size is a multiple of 16, at least 64. */
+	static const u64 K1K2[2] __attribute__ ((aligned (16))) = {0x0154442bd4ULL, 0x01c6e41596ULL};
+	static const u64 K3K4[2] __attribute__ ((aligned (16))) = {0x01751997d0ULL, 0x00ccaa009eULL};
+	static const u64 K5K0[2] __attribute__ ((aligned (16))) = {0x0163cd6124ULL, 0};
+	static const u64 POLY[2] __attribute__ ((aligned (16))) = {0x01db710641ULL, 0x01f7011641ULL};
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, mask;
+
+	x1 = _mm_loadu_si128 ((const __m128i*) (data + 0));
+	x2 = _mm_loadu_si128 ((const __m128i*) (data + 16));
+	x3 = _mm_loadu_si128 ((const __m128i*) (data + 32));
+	x4 = _mm_loadu_si128 ((const __m128i*) (data + 48));
+	x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 ((int) crc));
+	x0 = _mm_load_si128 ((const __m128i*) K1K2);
+	data += 64;
+	size -= 64;
+
+	while (size >= 64) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), _mm_loadu_si128 ((const __m128i*) (data + 0)));
+		x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), _mm_loadu_si128 ((const __m128i*) (data + 16)));
+		x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), _mm_loadu_si128 ((const __m128i*) (data + 32)));
+		x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), _mm_loadu_si128 ((const __m128i*) (data + 48)));
+		data += 64;
+		size -= 64;
+	}
+
+	/* fold the four lanes into one, then any blocks of 16 that are left */
+	x0 = _mm_load_si128 ((const __m128i*) K3K4);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+	while (size >= 16) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, _mm_loadu_si128 ((const __m128i*) data)), x5);
+		data += 16;
+		size -= 16;
+	}
+
+	/* 128 bits to 64 */
+	mask = _mm_setr_epi32 (~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128 (x1, x0, 0x10);
+	x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+	x0 = _mm_loadl_epi64 ((const __m128i*) K5K0);
+	x2 = _mm_srli_si128 (x1, 4);
+	x1 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask), x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	/* Barrett reduction to 32 bits */
+	x0 = _mm_load_si128 ((const __m128i*) POLY);
+	x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask), x0, 0x10);
+	x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x2, mask), x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+	return (u32) _mm_extract_epi32 (x1, 1) & 0xffffffffUL;
+}
+#endif
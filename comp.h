@@ -5,6 +5,58 @@
  *****************************************************************************/
 #include <stdio.h>
 
-int comp_inflate (unsigned char*, int, const unsigned char*, int);
+int comp_inflate (unsigned char*, int, const unsigned char*, int);           /*
+      @param: destination, destination size
+      @param: deflated source, source size
+      return: size written to destination, or -1 if the source is bad        */
+
+int comp_inflate_crc (unsigned char*, int, const unsigned char*, int, unsigned long*);
+/*    @param: destination, destination size
+      @param: deflated source, source size
+      @param: set to the CRC-32 of what was written, computed as it is
+              written rather than in a second pass over the destination
+      return: size written to destination, or -1 if the source is bad        */
+
+/* Streaming decompression keeps the block state, bit position, Huffman
+   tables and a 32 KiB sliding window between calls, so the input and the
+   output can be any size.                                                   */
+typedef struct comp_Stream* comp_stream;
+
+void comp_inflate_init (comp_stream*);
+void comp_inflate_end (comp_stream*);
+
+void comp_inflate_feed (comp_stream, const unsigned char*, int, int);        /*
+      @param: next chunk of deflated data; it must stay valid until
+              comp_inflate_drain() returns 0
+      @param: size of the chunk
+      @param: nonzero if it is the last chunk                                */
+
+int comp_inflate_drain (comp_stream, unsigned char*, int);                   /*
+      @param: destination, destination size
+      return: size written; 0 once the stream needs another chunk or has
+              ended, or -1 if the data is bad                                */
+
+int comp_inflate_finished (comp_stream);                                     /*
+      return: 1 if the last block has been decoded and drained, else 0       */
+
+#define COMP_DEFLATE_STORED 0
+#define COMP_DEFLATE_FASTEST 1
+#define COMP_DEFLATE_DEFAULT 6
+#define COMP_DEFLATE_BEST 9
+int comp_deflate (unsigned char*, int, const unsigned char*, int, int);      /*
+      @param: destination, destination size (see comp_deflate_bound())
+      @param: source, source size
+      @param: level, COMP_DEFLATE_STORED (0) to COMP_DEFLATE_BEST (9);
+              levels 1-3 take the first match, 4-9 search lazily
+      return: size written to destination, or -1 if it did not fit          */
+
+int comp_deflate_bound (int);                                                /*
+      @param: source size
+      return: largest size comp_deflate() can write for it, or -1 if
+              that does not fit an int                                       */
+
+unsigned long comp_crc32 (unsigned long, const unsigned char*, int);         /*
+      @param: CRC-32 so far (0 to start), data, size of data
+      return: CRC-32 including the data                                      */
 
 #endif
@@ -1,14 +1,341 @@
 #include "zip.h"
+#include "comp.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #define ASCII_CHAR_ZERO_TO_INT_ZERO -48
+#define TEST_ROUND_TRIP_FILE "test_round_trip.zip"
+
+/* Without an argument the behaviour checks below run, printing each one
+   that fails; with a local file number, that file of spreadsheet.ods is
+   described instead. */
+static int failures = 0;
+static void check (int condition, const char* what) {
+	if (!condition) {
+		printf ("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static void test_deflate (void) {
+
+	/* text-like, repetitive and incompressible data at every level */
+	static unsigned char src[100000], comp[101000], back[100000];
+	unsigned long seed;
+	seed = 1;
+	for (int i=0; i<sizeof (src); i++) {
+		seed = (seed * 1103515245 + 12345) & 0xffffffffUL;
+		src[i] = (i < 40000) ? "<table:table-cell office:value-type=\"float\"/>\n"[i % 46]
+			: (i < 70000) ? 'z' : (unsigned char) (seed >> 16);
+	}
+	check (comp_deflate_bound (sizeof (src)) <= sizeof (comp), "comp_deflate_bound() of 100000 bytes");
+	check (comp_deflate_bound (INT_MAX) == -1, "comp_deflate_bound() past INT_MAX is -1");
+	for (int level = COMP_DEFLATE_STORED; level <= COMP_DEFLATE_BEST; level++) {
+		int comp_size;
+		comp_size = comp_deflate (comp, sizeof (comp), src, sizeof (src), level);
+		check (comp_size > 0, "comp_deflate() succeeds");
+		check (comp_inflate (back, sizeof (back), comp, comp_size) == sizeof (src), "deflated data inflates to its size");
+		check (!memcmp (src, back, sizeof (src)), "deflated data inflates to itself");
+		if (level > COMP_DEFLATE_STORED)
+			check (comp_size < 40000, "deflate compresses the repetitive part");
+	}
+	check (comp_deflate (comp, 10, src, sizeof (src), COMP_DEFLATE_DEFAULT) == -1, "comp_deflate() into too small a buffer fails");
+
+	/* appended files read back, and survive a write and a reopen */
+	zip_object zip, reopened;
+	const char* names[] = {"mimetype", "content.xml", "random.bin", "empty"};
+	const int sizes[] = {46, 40000, 30000, 0};
+	const unsigned char* data[] = {(const unsigned char*) "application/vnd.oasis.opendocument.spreadsheet", src, src + 70000, src};
+	zip_constructor (&zip);
+	for (int i=0; i<4; i++) {
+		int method;
+		method = i ? ZIP_APPEND_DEFLATE_COMPRESSION : ZIP_APPEND_NO_COMPRESSION;
+		check (zip_append_file (zip, names[i], data[i], sizes[i], method) == i, "zip_append_file() returns the new file number");
+	}
+	check (zip_append_file (zip, "bad", src, 1, 99) == -1, "zip_append_file() refuses an unknown method");
+	check (zip_write_disk (zip, TEST_ROUND_TRIP_FILE) == ZIP_WRITE_SUCCESS, "zip_write_disk() succeeds");
+	zip_constructor (&reopened);
+	check (zip_open_disk (reopened, TEST_ROUND_TRIP_FILE) == ZIP_OPEN_SUCCESS, "a written archive opens");
+	for (int i=0; i<4; i++) {
+		zip_object from[2] = {zip, reopened};
+		for (int j=0; j<2; j++) {
+			unsigned char* file;
+			char name[ZIP_MAX_FILENAME_LENGTH];
+			file = NULL;
+			check (zip_get_file (from[j], i, &file) == sizes[i], "an appended file keeps its size");
+			check (file && !memcmp (file, data[i], sizes[i]), "an appended file keeps its data");
+			check (!strcmp (zip_get_filename (from[j], i, name, sizeof (name)), names[i]), "an appended file keeps its name");
+			free (file);
+		}
+	}
+	zip_destructor (&reopened);
+	zip_destructor (&zip);
+	remove (TEST_ROUND_TRIP_FILE);
+}
+
+static void test_directory (void) {
+
+	/* every entry of an opened archive is reachable by number and name */
+	zip_object zip;
+	char name[ZIP_MAX_FILENAME_LENGTH];
+	int count;
+	zip_constructor (&zip);
+	check (zip_open_disk (zip, "spreadsheet.ods") == ZIP_OPEN_SUCCESS, "spreadsheet.ods opens");
+	for (count = 0; zip_get_filename (zip, count, name, sizeof (name)); count++)
+		check (zip_search_filename (zip, name) == count, "zip_search_filename() finds each entry");
+	check (count == 17, "spreadsheet.ods has 17 entries");
+	check (!strcmp (zip_get_filename (zip, 3, name, sizeof (name)), "content.xml"), "entry 3 is content.xml");
+	check (zip_get_file_length (zip, 3) == 4143, "content.xml is 4143 bytes");
+	check (zip_search_filename (zip, "no such file") == -1, "zip_search_filename() of a missing name is -1");
+
+	/* appends grow the directory up to the classic limit of entries */
+	for (int i=0; i<70000 && zip_append_file (zip, "x", (const unsigned char*) "x", 1, ZIP_APPEND_NO_COMPRESSION) >= 0; i++)
+		count++;
+	check (count == 65535, "appends stop at 65535 entries");
+	check (zip_append_file (zip, "y", (const unsigned char*) "y", 1, ZIP_APPEND_DEFLATE_COMPRESSION) == -1, "an append past the limit fails");
+	check (!strcmp (zip_get_filename (zip, 3, name, sizeof (name)), "content.xml"), "names survive the directory growing");
+	check (!strcmp (zip_get_filename (zip, 65534, name, sizeof (name)), "x"), "the last appended name is kept");
+	check (zip_search_filename (zip, "x") == 17, "a repeated name finds its first entry");
+	zip_destructor (&zip);
+}
+
+static int count_matches (zip_object zip, zip_iterator* it) {
+
+	/* count the matches, checking that they come in filename order */
+	char previous[ZIP_MAX_FILENAME_LENGTH], name[ZIP_MAX_FILENAME_LENGTH];
+	int n, count;
+	count = 0;
+	previous[0] = 0;
+	while ((n = zip_next (zip, it)) >= 0) {
+		zip_get_filename (zip, n, name, sizeof (name));
+		check (strcmp (previous, name) <= 0, "matches come in filename order");
+		strcpy (previous, name);
+		count++;
+	}
+	return count;
+}
+
+static int count_glob (zip_object zip, const char* pattern) {
+
+	/* the pattern is copied to the heap, so that reading past its end is
+	   caught by a memory checker */
+	zip_iterator it;
+	char* copy;
+	int count;
+	if (!(copy = malloc (strlen (pattern) + 1)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	strcpy (copy, pattern);
+	zip_find_glob (zip, copy, &it);
+	count = count_matches (zip, &it);
+	free (copy);
+	return count;
+}
+
+static int count_prefix (zip_object zip, const char* prefix) {
+	zip_iterator it;
+	zip_find_prefix (zip, prefix, &it);
+	return count_matches (zip, &it);
+}
+
+static void test_queries (void) {
+
+	zip_object zip;
+	zip_constructor (&zip);
+	zip_open_disk (zip, "spreadsheet.ods");
+	check (count_prefix (zip, "") == 17, "the empty prefix matches every entry");
+	check (count_prefix (zip, "Configurations2/") == 9, "prefix Configurations2/");
+	check (count_prefix (zip, "Configurations2/images/") == 1, "prefix Configurations2/images/");
+	check (count_prefix (zip, "zzz") == 0, "a prefix after every name");
+	check (count_glob (zip, "*.xml") == 6, "glob *.xml");
+	check (count_glob (zip, "Configurations2/*/") == 8, "glob '*' crosses '/'");
+	check (count_glob (zip, "[cm]*.xml") == 2, "glob with a set");
+	check (count_glob (zip, "[!C]*") == 8, "glob with a negated set");
+	check (count_glob (zip, "[a-d]*") == 1, "glob with a range");
+	check (count_glob (zip, "m?ta.xml") == 1, "glob with '?'");
+	check (count_glob (zip, "content.xml[") == 0, "glob ending in '['");
+	check (count_glob (zip, "[!") == 0, "glob ending in \"[!\"");
+	zip_destructor (&zip);
+
+	/* an unclosed '[' is an ordinary character, and ']' may be in a set */
+	const char* names[] = {"a[", "[!", "a]", "ab"};
+	zip_constructor (&zip);
+	for (int i=0; i<4; i++)
+		zip_append_file (zip, names[i], (const unsigned char*) "x", 1, ZIP_APPEND_NO_COMPRESSION);
+	check (count_glob (zip, "a[") == 1, "glob \"a[\" matches itself");
+	check (count_glob (zip, "[!") == 1, "glob \"[!\" matches itself");
+	check (count_glob (zip, "a[]]") == 1, "glob with ']' first in a set");
+	check (count_glob (zip, "a[!]]") == 2, "glob with ']' first in a negated set");
+	check (count_prefix (zip, "a") == 3, "prefix of appended files");
+	zip_destructor (&zip);
+}
+
+static void put (FILE* fp, unsigned long long value, int size) {
+	for (int i=0; i<size; i++)
+		fputc ((value >> (8 * i)) & 0xff, fp);
+}
+
+static void write_zip64 (const char* fn, int with_offset_extra) {
+
+	/* Two stored files: the first has its sizes in the ZIP64 extra fields
+	   of both headers, the second only its offset in the central one; the
+	   counts and directory are in the EOCD64 record, found by its locator.
+	   Without the second extra field the directory is malformed. */
+	static const char first[] = "ZIP64 sizes\n", second[] = "ZIP64 offset\n";
+	unsigned long first_crc, second_crc;
+	long second_offset, cd_offset, eocd64_offset;
+	FILE* fp;
+	first_crc = comp_crc32 (0, (const unsigned char*) first, 12);
+	second_crc = comp_crc32 (0, (const unsigned char*) second, 13);
+	if (!(fp = fopen (fn, "wb")))
+		return;
+	put (fp, 0x04034b50, 4), put (fp, 45, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4);
+	put (fp, first_crc, 4), put (fp, 0xffffffff, 4), put (fp, 0xffffffff, 4), put (fp, 9, 2), put (fp, 20, 2);
+	fputs ("first.txt", fp), put (fp, 1, 2), put (fp, 16, 2), put (fp, 12, 8), put (fp, 12, 8);
+	fputs (first, fp);
+	second_offset = ftell (fp);
+	put (fp, 0x04034b50, 4), put (fp, 20, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4);
+	put (fp, second_crc, 4), put (fp, 13, 4), put (fp, 13, 4), put (fp, 10, 2), put (fp, 0, 2);
+	fputs ("second.txt", fp);
+	fputs (second, fp);
+
+	cd_offset = ftell (fp);
+	put (fp, 0x02014b50, 4), put (fp, 45, 2), put (fp, 45, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4);
+	put (fp, first_crc, 4), put (fp, 0xffffffff, 4), put (fp, 0xffffffff, 4), put (fp, 9, 2), put (fp, 20, 2);
+	put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4), put (fp, 0, 4);
+	fputs ("first.txt", fp), put (fp, 1, 2), put (fp, 16, 2), put (fp, 12, 8), put (fp, 12, 8);
+	put (fp, 0x02014b50, 4), put (fp, 45, 2), put (fp, 45, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4);
+	put (fp, second_crc, 4), put (fp, 13, 4), put (fp, 13, 4), put (fp, 10, 2), put (fp, with_offset_extra ? 12 : 0, 2);
+	put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0, 4), put (fp, 0xffffffff, 4);
+	fputs ("second.txt", fp);
+	if (with_offset_extra)
+		put (fp, 1, 2), put (fp, 8, 2), put (fp, second_offset, 8);
+
+	eocd64_offset = ftell (fp);
+	put (fp, 0x06064b50, 4), put (fp, 44, 8), put (fp, 45, 2), put (fp, 45, 2), put (fp, 0, 4), put (fp, 0, 4);
+	put (fp, 2, 8), put (fp, 2, 8), put (fp, eocd64_offset - cd_offset, 8), put (fp, cd_offset, 8);
+	put (fp, 0x07064b50, 4), put (fp, 0, 4), put (fp, eocd64_offset, 8), put (fp, 1, 4);
+	put (fp, 0x06054b50, 4), put (fp, 0, 2), put (fp, 0, 2), put (fp, 0xffff, 2), put (fp, 0xffff, 2);
+	put (fp, 0xffffffff, 4), put (fp, 0xffffffff, 4), put (fp, 0, 2);
+	fclose (fp);
+}
+
+static void test_zip64 (void) {
+
+	zip_object zip;
+	unsigned char* file;
+	char name[ZIP_MAX_FILENAME_LENGTH];
+	for (int mmap_enabled = 0; mmap_enabled < 2; mmap_enabled++) {
+		write_zip64 (TEST_ROUND_TRIP_FILE, 1);
+		zip_constructor (&zip);
+		zip_set_mmap (zip, mmap_enabled);
+		zip_set_verify_crc (zip, 1);
+		check (zip_open_disk (zip, TEST_ROUND_TRIP_FILE) == ZIP_OPEN_SUCCESS, "a ZIP64 archive opens");
+		check (zip_get_filename (zip, 1, name, sizeof (name)) && !zip_get_filename (zip, 2, name, sizeof (name)), "the EOCD64 record gives the entry count");
+		check (zip_get_file_length (zip, 0) == 12, "a size from the ZIP64 extra field");
+		file = NULL;
+		check (zip_get_file (zip, 0, &file) == 12 && !memcmp (file, "ZIP64 sizes\n", 12), "a file with ZIP64 local sizes reads back");
+		free (file);
+		file = NULL;
+		check (zip_get_file (zip, 1, &file) == 13 && !memcmp (file, "ZIP64 offset\n", 13), "a file at a ZIP64 offset reads back");
+		free (file);
+		check (zip_search_filename (zip, "second.txt") == 1, "names after a ZIP64 extra field");
+		zip_destructor (&zip);
+
+		write_zip64 (TEST_ROUND_TRIP_FILE, 0);
+		zip_constructor (&zip);
+		zip_set_mmap (zip, mmap_enabled);
+		check (zip_open_disk (zip, TEST_ROUND_TRIP_FILE) == ZIP_OPEN_FAILURE, "a marked field missing from the extra field fails");
+		zip_destructor (&zip);
+	}
+	remove (TEST_ROUND_TRIP_FILE);
+}
+
+static void test_cache (void) {
+
+	/* spreadsheet.ods file 2 is settings.xml (7320 bytes), 3 content.xml
+	   (4143), 4 meta.xml (839), 5 styles.xml (7295) and 16
+	   META-INF/manifest.xml (1093) */
+	zip_object zip;
+	zip_cache_stats stats;
+	unsigned char* content;
+	const unsigned char *held, *again;
+	unsigned long long size;
+	zip_constructor (&zip);
+	zip_open_disk (zip, "spreadsheet.ods");
+	content = NULL;
+	zip_get_file (zip, 3, &content);
+	zip_set_cache (zip, 10000);
+
+	/* a repeated read is a hit on the same buffer */
+	held = zip_get_file_cached (zip, 3, &size);
+	again = zip_get_file_cached (zip, 3, &size);
+	zip_get_cache_stats (zip, &stats);
+	check (held && held == again && size == 4143, "a cached file is shared");
+	check (!memcmp (held, content, 4143), "a cached file has its data");
+	check (stats.hits == 1 && stats.misses == 1 && stats.entries == 1 && stats.bytes == 4143, "one miss then one hit");
+	zip_release_file (zip, again);
+
+	/* past the budget the oldest goes, but stays valid while held */
+	zip_release_file (zip, zip_get_file_cached (zip, 5, &size));
+	zip_get_cache_stats (zip, &stats);
+	check (stats.evictions == 1 && stats.entries == 1 && stats.bytes == 7295, "the least recently used is evicted");
+	check (!memcmp (held, content, 4143), "an evicted file stays valid while referenced");
+	zip_release_file (zip, held);
+
+	/* a hit makes a file the most recently used */
+	zip_set_cache (zip, 0);
+	zip_set_cache (zip, 10000);
+	zip_release_file (zip, zip_get_file_cached (zip, 4, &size));
+	zip_release_file (zip, zip_get_file_cached (zip, 16, &size));
+	zip_release_file (zip, zip_get_file_cached (zip, 3, &size));
+	zip_release_file (zip, zip_get_file_cached (zip, 4, &size));
+	zip_release_file (zip, zip_get_file_cached (zip, 2, &size));
+	zip_get_cache_stats (zip, &stats);
+	check (stats.entries == 2 && stats.bytes == 839 + 7320, "eviction follows recency, not insertion");
+	zip_release_file (zip, zip_get_file_cached (zip, 4, &size));
+	zip_get_cache_stats (zip, &stats);
+	check (stats.hits == 3, "a recently used file is kept");
+
+	/* zip_get_file() copies from the cache; larger files bypass it */
+	unsigned char* copy;
+	copy = NULL;
+	check (zip_get_file (zip, 3, &copy) == 4143 && !memcmp (copy, content, 4143), "zip_get_file() with the cache");
+	free (copy);
+	zip_set_cache (zip, 1000);
+	held = zip_get_file_cached (zip, 3, &size);
+	zip_get_cache_stats (zip, &stats);
+	check (held && !memcmp (held, content, 4143) && stats.entries == 0, "a file over the budget is not cached");
+	zip_release_file (zip, held);
+	zip_set_cache (zip, 0);
+	zip_get_cache_stats (zip, &stats);
+	check (stats.entries == 0 && stats.bytes == 0, "a budget of 0 empties the cache");
+	check (!zip_get_file_cached (zip, 99, &size), "a missing file is not cached");
+	free (content);
+	zip_destructor (&zip);
+}
+
+static int run_tests (void) {
+	test_deflate ();
+	test_directory ();
+	test_queries ();
+	test_zip64 ();
+	test_cache ();
+	if (failures)
+		printf ("%d checks failed\n", failures);
+	else
+		printf ("all checks passed\n");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
 int main (int argc, char* argv[]) {
 
 	/* get command line parameters */
 	int local_file, index;
+	if (argc == 1)
+		return run_tests ();
 	if (argc != 2) {
-		printf ("usage: %s <integer>\n", argv[0]);
+		printf ("usage: %s [<integer>]\n", argv[0]);
 		exit (EXIT_FAILURE);
 	}
 	else {
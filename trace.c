@@ -0,0 +1,29 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+#define TRACE_MAX_MESSAGE_LENGTH 512
+
+/* set once before any tracing starts; not guarded against concurrent calls */
+static trace_sink current_sink = NULL;
+static void* current_context = NULL;
+
+void trace_set_sink (trace_sink sink, void* context) {
+	current_sink = sink;
+	current_context = context;
+}
+
+void trace_message (int level, const char* format, ...) {
+
+	char message[TRACE_MAX_MESSAGE_LENGTH];
+	va_list args;
+
+	va_start (args, format);
+	vsnprintf (message, TRACE_MAX_MESSAGE_LENGTH, format, args);
+	va_end (args);
+
+	if (current_sink)
+		current_sink (level, message, current_context);
+	else
+		fputs (message, stdout);
+}
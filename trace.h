@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+/*****************************************************************************
+ *        trace.h - Diagnostic Messages with Compile-Time Levels             *
+ *****************************************************************************/
+
+/* Messages above TRACE_LEVEL compile to nothing, so the default build pays
+   nothing for them. Build with e.g. "make TRACE_LEVEL=2" to get the
+   per-block inflate diagnostics back.                                       */
+#define TRACE_LEVEL_NONE 0
+#define TRACE_LEVEL_ERROR 1   /* bad data the caller is told about anyway   */
+#define TRACE_LEVEL_BLOCK 2   /* one message per deflate block or entry     */
+#define TRACE_LEVEL_DETAIL 3  /* dumps of code length tables                */
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_NONE
+#endif
+
+typedef void (*trace_sink) (int, const char*, void*);                        /*
+      @param: level of the message
+      @param: message text, ending in a newline
+      @param: context pointer given to trace_set_sink()                      */
+
+void trace_set_sink (trace_sink, void*);                                     /*
+      @param: sink for all messages, or NULL to print them on stdout
+      @param: context pointer passed to the sink                             */
+
+void trace_message (int, const char*, ...);                                  /*
+      @param: level, printf() format and arguments; use the macros below     */
+
+#if TRACE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(...) trace_message (TRACE_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define TRACE_ERROR(...) ((void) 0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_BLOCK
+#define TRACE_BLOCK(...) trace_message (TRACE_LEVEL_BLOCK, __VA_ARGS__)
+#else
+#define TRACE_BLOCK(...) ((void) 0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DETAIL
+#define TRACE_DETAIL(...) trace_message (TRACE_LEVEL_DETAIL, __VA_ARGS__)
+#else
+#define TRACE_DETAIL(...) ((void) 0)
+#endif
+
+#endif
@@ -1,8 +1,49 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE				/* syscall(), for io_uring */
+#define _FILE_OFFSET_BITS 64
 #include "zip.h"
+#include "comp.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
 
+/* disks are memory mapped where the platform has mmap(), and read through
+   pread() or else stdio otherwise; only stdio reads share a file position,
+   so only they cannot be made by several threads at once */
+#if defined (__unix__) || defined (__APPLE__)
+#define ZIP_HAVE_MMAP 1
+#define ZIP_HAVE_PREAD 1
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#define ZIP_ADVICE_SEQUENTIAL POSIX_MADV_SEQUENTIAL
+#define ZIP_ADVICE_RANDOM POSIX_MADV_RANDOM
+#define ZIP_ADVICE_WILLNEED POSIX_MADV_WILLNEED
+#else
+#define ZIP_ADVICE_SEQUENTIAL 0
+#define ZIP_ADVICE_RANDOM 0
+#define ZIP_ADVICE_WILLNEED 0
+#endif
+
+/* batched reads go through io_uring where the kernel headers have it, with
+   the raw system calls so that no library is needed; whether the running
+   kernel allows it is only known once a ring is set up */
+#if defined (__linux__) && defined (__has_include) && defined (ZIP_HAVE_PREAD)
+#if __has_include (<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined (__NR_io_uring_setup) && defined (__NR_io_uring_enter)
+#define ZIP_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+typedef unsigned long long int u64;
 typedef unsigned char u8;
 typedef unsigned short u16;
 typedef unsigned long u32;
@@ -11,12 +52,50 @@ typedef unsigned long u32;
 #define ZIP_EOCDR_FIXED_PORTION_SIZE 22
 #define ZIP_SIGNATURE_FIELD_SIZE 4
 #define ZIP_LENGTH_FIELD_SIZE 2
+#define ZIP_MAX_COMMENT_LENGTH 65535
+#define ZIP_STACK_READ_SIZE 16384 /* larger unmapped files are read into the heap */
 #define ZIP_EOCDR_SIGNATURE 0x06054b50
 #define ZIP_CDFH_FIXED_SIZE 46
 #define ZIP_LFH_FIXED_SIZE 30
 #define ZIP_DATA_DESCRIPTOR_FLAG 8
+#define ZIP_LFH_SIGNATURE 0x04034b50
+#define ZIP_CDFH_SIGNATURE 0x02014b50
+#define ZIP_VERSION_STORED 10		/* version needed to extract, times ten */
+#define ZIP_VERSION_DEFLATE 20
+#define ZIP_VERSION_MADE_BY 20		/* MS-DOS attributes, spec. 2.0 */
+#define ZIP_DEFLATE_MAXIMUM_FLAG 2	/* general purpose bits 1 and 2 */
+#define ZIP_DEFLATE_FAST_FLAG 4
+#define ZIP_EOCD64_LOCATOR_SIGNATURE 0x07064b50
+#define ZIP_EOCD64_LOCATOR_SIZE 20
+#define ZIP_EOCD64_SIGNATURE 0x06064b50
+#define ZIP_EOCD64_FIXED_SIZE 56
+#define ZIP64_EXTRA_FIELD_ID 0x0001
+#define ZIP64_MARKER_16 0xffff		/* a classic field that is in the ZIP64 fields instead */
+#define ZIP64_MARKER_32 0xffffffffUL
+#define ZIP_INFLATE_CHUNK_SIZE 0x40000000 /* comp_inflate() sizes are ints */
+#define ZIP_STREAM_CHUNK_SIZE 65536	/* zip_extract_stream() input and output blocks */
 
-static u32 zip_get_field (FILE*, int); /* file stream, field size (bytes) */
+static int zip_put_field (FILE*, u32, int); /* file stream, value, field size (bytes) */
+static u32 zip_load (const u8*, int); /* buffer, field size (bytes) */
+static u64 zip_load64 (const u8*);
+static int zip_read_at (struct zip_Object*, u32, u64, u8*, u64);
+/* object, disk, offset, destination, length; returns nonzero on failure */
+static int zip_read_file (struct zip_Object*, u32, u64, u8*, u64);
+/* as zip_read_at(), but through the file even if the disk is mapped, and
+   the range must be on the disk */
+static const u8* zip_read_view (struct zip_Object*, u32, u64, u64, u8*);
+/* object, disk, offset, length, scratch buffer used if the disk is not mapped */
+static void zip_advise (struct zip_Object*, u32, u64, u64, int);
+/* object, disk, offset, length, ZIP_ADVICE_... */
+static void zip_reserve (struct zip_Object*, u32, u32); /* object, headers, arena bytes */
+static u32 zip_hash_name (const char*);
+static void zip_build_name_index (struct zip_Object*, u32); /* object, minimum entries */
+static void zip_index_name (struct zip_Object*, u32); /* object, local file number */
+static void zip_build_sorted_index (struct zip_Object*);
+static int zip_sorted_cmp (const void*, const void*);
+static u32 zip_lower_bound (struct zip_Object*, const char*, int, int);
+/* object, prefix, prefix length, also skip names equal to the prefix */
+static int zip_glob_match (const char*, const char*); /* pattern, name */
 
 /* Below are the fundamental states of the zip object. They can occur only
    in increasing order, but some state may be skipped. For example calling
@@ -25,34 +104,252 @@ static u32 zip_get_field (FILE*, int); /* file stream, field size (bytes) */
 */
 #define ZIP_STATE_WITHOUT_FORM 0
 #define ZIP_STATE_CENTRAL_DIRECTORY_COMPLETE 1
+#define ZIP_STATE_APPEND_FILES 2
 
 typedef struct zip_central_directory_file_header* cdfh;
 struct zip_central_directory_file_header {
+	u16 version_made_by;
 	u16 version;
 	u16 bit_flag;
 	u16 comp_method;
+	u16 mod_time, mod_date;
 	u32 crc_32;
-	u32 comp_size;
-	u32 uncomp_size;
+	u64 comp_size;
+	u64 uncomp_size;
 	u16 fnl, efl, fcl; /* file name length, extra field len, file comment len */
-	u16 disk;
+	u32 disk;
 	u16 int_attr;
 	u32 ext_attr;
-	u32 offset;
-	char* file_name;
-	u8* extra_field;
-	char* file_comment;
-	cdfh next_cdfh, prev_cdfh;
+	u64 offset;
+	u32 file_name, extra_field, file_comment; /* offsets into the arena */
+	u8* data; /* compressed data of an appended file, NULL if it is on disk */
+};
+
+static int zip_read_zip64_extra (cdfh, const u8*);
+/* header with ZIP64 markers, its extra field; returns nonzero if malformed */
+static int zip_locate_data (struct zip_Object*, cdfh, u64*);
+/* object, header, set to the offset of the compressed data;
+   returns nonzero on failure */
+static const u8* zip_entry_data (struct zip_Object*, cdfh, u8*);
+/* object, header, buffer for data on a disk that is not mapped (or NULL);
+   returns the compressed data, or NULL */
+
+/* Extracted files are cached, up to a budget of bytes, in a table keyed by
+   local file number and a list from the most to the least recently used.
+   Each entry is one allocation with the data after it, so a buffer given
+   out leads back to its entry. An entry evicted while it is referenced
+   leaves the table and is freed by its last zip_release_file(). */
+#define ZIP_CACHE_MINIMUM_TABLE 64
+typedef struct zip_cache_entry cache_entry;
+struct zip_cache_entry {
+	int n;
+	u64 size;
+	u32 refs;
+	int cached;						/* still in the table and the list */
+	cache_entry *newer, *older;		/* recency list */
+	cache_entry* chain;				/* next in the same table slot */
+};
+#define ZIP_CACHE_DATA(entry) ((u8*) ((entry) + 1))
+
+static cache_entry* zip_cache_find (struct zip_Object*, int);
+static void zip_cache_touch (struct zip_Object*, cache_entry*); /* make it the newest */
+static void zip_cache_insert (struct zip_Object*, cache_entry*);
+static void zip_cache_evict (struct zip_Object*, cache_entry*);
+static void zip_cache_trim (struct zip_Object*); /* evict until within the budget */
+static long long zip_decode (struct zip_Object*, int, const u8*, u8*);
+/* object, local file number, its compressed data, destination of at least
+   its uncompressed size; returns the size written, or -1 */
+static long long zip_inflate (u8*, u64, const u8*, u64, u32*);
+/* destination, its size, source, its size, CRC-32 of the output or NULL;
+   returns the size written, or -1 */
+static u32 zip_crc32 (const u8*, u64); /* data, size */
+
+/* The name index is an open addressing hash table with linear probing,
+   kept at most half full. */
+typedef struct zip_name_slot name_slot;
+struct zip_name_slot {
+	u32 hash;
+	u32 entry; /* local file number + 1, or 0 if the slot is empty */
+};
+
+/* Name and local file number pairs, only used while sorting */
+typedef struct zip_sorted_name sorted_name;
+struct zip_sorted_name {
+	const char* name;
+	u32 entry;
+};
+
+/* Bulk extraction deals the files, largest first, round-robin into one queue
+   per worker. A worker takes from the front of its own queue and, once that
+   is empty, steals from the back of the others, where the smallest are. */
+typedef struct zip_extract_queue extract_queue;
+struct zip_extract_queue {
+	int* files;
+	int head, tail;				/* the queue is files[head] to files[tail-1] */
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t lock;
+#endif
+};
+
+typedef struct zip_extract_pool extract_pool;
+struct zip_extract_pool {
+	struct zip_Object* obj;
+	extract_queue* queues;
+	int workers;
+	zip_extract_callback callback;
+	void* ctx;
+	int stop;					/* set once a callback returns nonzero */
+	int extracted;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t lock;		/* protects stop and extracted */
+#endif
 };
 
+typedef struct zip_extract_worker extract_worker;
+struct zip_extract_worker {
+	extract_pool* pool;
+	int id;
+};
+
+static void* zip_extract_work (void*); /* extract_worker* */
+static int zip_extract_take (extract_pool*, int, int*);
+/* pool, worker id, set to the file taken; returns 0 once there are none */
+static int zip_u64_cmp (const void*, const void*);
+
+/* Pipelined extraction reads the files in the order they are on the disks
+   into a ring of buffers on one thread, while the calling thread inflates
+   them and runs the callback. */
+#define ZIP_PIPELINE_SLOTS 4
+typedef struct zip_pipeline_slot pipeline_slot;
+struct zip_pipeline_slot {
+	int n;
+	const u8* data;				/* compressed data, or NULL if it could not be read */
+	u8* buffer;					/* grown to the largest file read into the slot */
+	u64 buffer_size;
+};
+
+typedef struct zip_extract_pipeline extract_pipeline;
+struct zip_extract_pipeline {
+	struct zip_Object* obj;
+	const int* order;			/* the files in disk and offset order */
+	int count;
+	pipeline_slot slots[ZIP_PIPELINE_SLOTS];
+	int read, decoded;			/* files put into and taken out of the ring */
+	int stop;					/* set once a callback returns nonzero */
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t lock;
+	pthread_cond_t filled, emptied;
+#endif
+};
+
+typedef struct zip_file_position file_position;
+struct zip_file_position {
+	u32 disk;					/* appended and unknown files sort last */
+	u64 offset;
+	int n;
+};
+
+#ifdef ZIP_HAVE_PREAD
+static void* zip_pipeline_read (void*); /* extract_pipeline* */
+#endif
+static void zip_pipeline_fill (struct zip_Object*, pipeline_slot*, int); /* object, slot, file */
+static int zip_position_cmp (const void*, const void*);
+
+/* Batched extraction reads each file's local header and data with a single
+   read, all of them in flight at once, and inflates the files on the
+   calling thread in the order the reads complete, with at most
+   ZIP_BATCH_DEPTH reads ahead of it. The read is sized from the central
+   directory with some slack for a longer local extra field; anything it
+   misses is read when the file is inflated. */
+#define ZIP_BATCH_SLACK 64
+#define ZIP_BATCH_THREADS 8			/* reading threads when io_uring cannot be used */
+#define ZIP_BATCH_DEPTH 64
+#define ZIP_BATCH_MAXIMUM_READ 0x40000000 /* larger files are read when inflated */
+typedef struct zip_batch_read batch_read;
+struct zip_batch_read {
+	int n;
+	u32 disk;
+	u64 offset, length;			/* from the local file header to past the data */
+	u8* buffer;					/* allocated when the read is made */
+	u64 got;					/* bytes read so far */
+	int queued;					/* io_uring: handed to the kernel */
+};
+
+typedef struct zip_extract_batch extract_batch;
+struct zip_extract_batch {
+	struct zip_Object* obj;
+	batch_read* reads;
+	int count;
+	zip_extract_callback callback;
+	void* ctx;
+	u8* buffer;					/* inflated data, grown to the largest file */
+	u64 buffer_size;
+	int extracted;
+	int stop;					/* set once a callback returns nonzero */
+	int next;					/* reading threads: next read to take */
+	int* done;					/* reading threads: reads in order of completion */
+	int done_count, taken;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t lock;
+	pthread_cond_t completed, taken_one;
+#endif
+};
+
+static int zip_batch_deliver (extract_batch*, int, const u8*);
+/* batch, local file number, its compressed data or NULL; returns nonzero
+   if the callback asks to stop */
+static const u8* zip_batch_data (struct zip_Object*, batch_read*);
+/* object, completed read; returns the compressed data, or NULL */
+#ifdef ZIP_HAVE_PREAD
+static void* zip_batch_work (void*); /* extract_batch* */
+#endif
+#ifdef ZIP_HAVE_IO_URING
+typedef struct zip_uring uring;
+struct zip_uring {
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	unsigned entries;
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+	void *sq_ring, *cq_ring;
+	size_t sq_ring_size, cq_ring_size, sqes_size;
+};
+static int zip_uring_setup (uring*); /* returns nonzero if the kernel refuses */
+static void zip_uring_close (uring*);
+static void zip_batch_uring (extract_batch*, uring*);
+#endif
+
 struct zip_Object {
 	int state;
 	FILE* disks[ZIP_MAXIMUM_NUMBER_OF_DISKS];
-	u32 disk_sizes[ZIP_MAXIMUM_NUMBER_OF_DISKS];
+	u8* maps[ZIP_MAXIMUM_NUMBER_OF_DISKS]; /* whole disk mapped read-only, or NULL */
+	int mmap_enabled;
+	u64 disk_sizes[ZIP_MAXIMUM_NUMBER_OF_DISKS];
 	int number_of_disks;
-	cdfh central_dir;
-	u16 total_cd_entries;
+	cdfh central_dir; /* array of headers, followed by the arena in the same allocation */
+	u32 cd_capacity;
+	char* arena; /* file names, extra fields and file comments, each NUL terminated */
+	u32 arena_size, arena_capacity;
+	u32 total_cd_entries;
+	int name_index_enabled;
+	name_slot* name_index;
+	u32 name_index_size; /* a power of two, or 0 without an index */
+	u32* sorted_index; /* local file numbers in filename order, built on first use */
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t sorted_index_lock; /* held only while it is built */
+#endif
 	char* zip_file_comment;
+	int deflate_level;
+	int verify_crc;
+	u64 cache_budget, cache_bytes; /* no cache while the budget is 0 */
+	cache_entry** cache_table;
+	u32 cache_table_size, cache_entries; /* a power of two, or 0 */
+	cache_entry *cache_newest, *cache_oldest;
+	u64 cache_hits, cache_misses, cache_evictions;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_t cache_lock;
+#endif
 };
 
 void zip_constructor (struct zip_Object** ptr_ptr) {
@@ -66,34 +363,72 @@ void zip_constructor (struct zip_Object** ptr_ptr) {
 	/* initialize variables */
 	obj_ptr->state = ZIP_STATE_WITHOUT_FORM;
 	obj_ptr->number_of_disks = 0;
+	obj_ptr->mmap_enabled = 1;
 	obj_ptr->central_dir = NULL;
+	obj_ptr->cd_capacity = 0;
+	obj_ptr->arena = NULL;
+	obj_ptr->arena_size = 0;
+	obj_ptr->arena_capacity = 0;
 	obj_ptr->total_cd_entries = 0;
+	obj_ptr->name_index_enabled = 1;
+	obj_ptr->name_index = NULL;
+	obj_ptr->name_index_size = 0;
+	obj_ptr->sorted_index = NULL;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_init (&obj_ptr->sorted_index_lock, NULL);
+#endif
 	obj_ptr->zip_file_comment = NULL;
+	obj_ptr->deflate_level = COMP_DEFLATE_DEFAULT;
+	obj_ptr->verify_crc = 0;
+	obj_ptr->cache_budget = 0;
+	obj_ptr->cache_bytes = 0;
+	obj_ptr->cache_table = NULL;
+	obj_ptr->cache_table_size = 0;
+	obj_ptr->cache_entries = 0;
+	obj_ptr->cache_newest = NULL;
+	obj_ptr->cache_oldest = NULL;
+	obj_ptr->cache_hits = 0;
+	obj_ptr->cache_misses = 0;
+	obj_ptr->cache_evictions = 0;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_init (&obj_ptr->cache_lock, NULL);
+#endif
 }
 
 void zip_destructor (struct zip_Object** ptr_ptr) {
 
 	struct zip_Object* obj_ptr = *ptr_ptr;
 	
-	/* deallocate the central_dir linked list */
-	if (obj_ptr->central_dir) {
-		cdfh current, next;
-		current = obj_ptr->central_dir;
-		while (current) {
-			next = current->next_cdfh;
-			free ((current->file_name));
-			free ((current->extra_field));
-			free ((current->file_comment));
-			free (current);
-			current = next;
-		}
+	/* deallocate the central directory and the data of appended files */
+	for (int i=0; i<obj_ptr->total_cd_entries; i++)
+		free (obj_ptr->central_dir[i].data);
+	free (obj_ptr->central_dir);
+	free (obj_ptr->name_index);
+	free (obj_ptr->sorted_index);
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_destroy (&obj_ptr->sorted_index_lock);
+#endif
+
+	/* deallocate the cache, including entries that are still referenced */
+	while (obj_ptr->cache_newest) {
+		cache_entry* entry = obj_ptr->cache_newest;
+		obj_ptr->cache_newest = entry->older;
+		free (entry);
 	}
+	free (obj_ptr->cache_table);
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_destroy (&obj_ptr->cache_lock);
+#endif
 
 	/* deallocate the zip file comment */
 	free (obj_ptr->zip_file_comment);
 
 	/* close all open disks */
 	for (int i=0; i< obj_ptr->number_of_disks; i++) {
+#ifdef ZIP_HAVE_MMAP
+		if (obj_ptr->maps[i])
+			munmap (obj_ptr->maps[i], obj_ptr->disk_sizes[i]);
+#endif
 		fclose (obj_ptr->disks[i]);
 	}
 	
@@ -123,174 +458,239 @@ int zip_open_disk (struct zip_Object* obj, const char* fn) {
 	}
 	else {
 		obj->disks[obj->number_of_disks] = fp;
+#ifdef ZIP_HAVE_PREAD
+		obj->disk_sizes[obj->number_of_disks] = ftello (fp);
+#else
 		obj->disk_sizes[obj->number_of_disks] = ftell (fp);
+#endif
+		obj->maps[obj->number_of_disks] = NULL;
 		obj->number_of_disks++;
 	}
 
-	/* attempt to find the End of Central Directory Record */
-	u32 eocdr_pos, cur_pos, cur_val;
+	/* map the disk if possible; files are then read in no particular order */
+#ifdef ZIP_HAVE_MMAP
+	if (obj->mmap_enabled && obj->disk_sizes[obj->number_of_disks-1]
+		&& (size_t) obj->disk_sizes[obj->number_of_disks-1] == obj->disk_sizes[obj->number_of_disks-1]) {
+		void* map;
+		map = mmap (NULL, obj->disk_sizes[obj->number_of_disks-1], PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+		if (map != MAP_FAILED) {
+			obj->maps[obj->number_of_disks-1] = map;
+			zip_advise (obj, obj->number_of_disks-1, 0, obj->disk_sizes[obj->number_of_disks-1], ZIP_ADVICE_RANDOM);
+		}
+	}
+#endif
 
-	if (fseek (fp, (-1)*ZIP_EOCDR_FIXED_PORTION_SIZE, SEEK_END))
+	/* attempt to find the End of Central Directory Record; it is in the
+	   last 22 bytes plus the longest possible file comment, so read those
+	   at once and search backwards from the last possible position */
+	const u8* tail;
+	u8* tail_buffer;
+	u64 tail_size, tail_pos;
+	int found;
+	tail_size = obj->disk_sizes[obj->number_of_disks-1];
+	if (tail_size < ZIP_EOCDR_FIXED_PORTION_SIZE)
 		return ZIP_OPEN_FAILURE;
+	if (tail_size > ZIP_EOCDR_FIXED_PORTION_SIZE + ZIP_MAX_COMMENT_LENGTH)
+		tail_size = ZIP_EOCDR_FIXED_PORTION_SIZE + ZIP_MAX_COMMENT_LENGTH;
+	tail_buffer = NULL;
+	if (!obj->maps[obj->number_of_disks-1] && !(tail_buffer = malloc (tail_size)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	tail = zip_read_view (obj, obj->number_of_disks-1,
+		obj->disk_sizes[obj->number_of_disks-1] - tail_size, tail_size, tail_buffer);
+	if (!tail) {
+		free (tail_buffer);
+		return ZIP_OPEN_FAILURE;
+	}
 
-	eocdr_pos = 0;
-	cur_pos = ftell (fp);
-	do {
-		cur_val = zip_get_field (fp, ZIP_SIGNATURE_FIELD_SIZE);
-		cur_pos += ZIP_SIGNATURE_FIELD_SIZE;
-
-		if (cur_val == ZIP_EOCDR_SIGNATURE) {
-			/* possible match, verify with comment length field. */
-			u32 pos_pos, fcl_offset, fcl;
-			pos_pos = cur_pos - ZIP_SIGNATURE_FIELD_SIZE;
-			fcl_offset = ZIP_EOCDR_FIXED_PORTION_SIZE - ZIP_SIGNATURE_FIELD_SIZE - ZIP_LENGTH_FIELD_SIZE;
-
-			if (fseek (fp, fcl_offset, SEEK_CUR))
-				return ZIP_OPEN_FAILURE;
-			cur_pos += fcl_offset;
-
-			fcl = zip_get_field (fp, ZIP_LENGTH_FIELD_SIZE);
-			cur_pos += ZIP_LENGTH_FIELD_SIZE;
-
-			if (obj->disk_sizes[obj->number_of_disks-1] == cur_pos) {
-				eocdr_pos = pos_pos;
-				break;
-			}
-			else
-				cur_pos = pos_pos;
-		}
-		else {
-			/* if not a match, then back up to a new starting position and continue */
-			if (fseek (fp, (-1)-ZIP_SIGNATURE_FIELD_SIZE, SEEK_CUR))
-				return ZIP_OPEN_FAILURE;
-			cur_pos -= (-1) - ZIP_SIGNATURE_FIELD_SIZE;
+	found = 0;
+	tail_pos = tail_size - ZIP_EOCDR_FIXED_PORTION_SIZE + 1;
+	while (tail_pos-- > 0) {
+		/* possible match, verify with comment length field. */
+		if (tail[tail_pos] == 0x50 && zip_load (tail + tail_pos, ZIP_SIGNATURE_FIELD_SIZE) == ZIP_EOCDR_SIGNATURE
+			&& tail_pos + ZIP_EOCDR_FIXED_PORTION_SIZE + zip_load (tail + tail_pos + 20, ZIP_LENGTH_FIELD_SIZE) == tail_size) {
+			found = 1;
+			break;
 		}
-	} while (cur_pos >= 0);
+	}
 
 	/* check that the EOCDR was found */
-	if (!eocdr_pos)
+	if (!found) {
+		free (tail_buffer);
 		return ZIP_OPEN_NEED_ADDITIONAL_DISK;
+	}
 	else
 		obj->state = ZIP_STATE_CENTRAL_DIRECTORY_COMPLETE;
 
 	/* EOCDR is found, parse it */
-	u32 signature;
-	u16 this_disk;
-	u16 start_disk;
-	u16 this_disk_entries;
-	u16 tot_entries;
-	u32 cd_size;
-	u32 cd_offset;
+	const u8* eocdr;
+	u64 eocdr_offset;
+	u32 start_disk;
+	u64 tot_entries;
+	u64 cd_size;
+	u64 cd_offset;
 	u16 fc_length;
-	
-	if (fseek (fp, eocdr_pos, SEEK_SET))
-		return ZIP_OPEN_FAILURE;
 
-	signature = zip_get_field (fp, ZIP_SIGNATURE_FIELD_SIZE);
-	this_disk = zip_get_field (fp, 2);
-	start_disk = zip_get_field (fp, 2);
-	this_disk_entries = zip_get_field (fp, 2);
-	tot_entries = zip_get_field (fp, 2);
-	cd_size = zip_get_field (fp, 4);
-	cd_offset = zip_get_field (fp, 4);
-	fc_length = zip_get_field (fp, 2);
+	eocdr = tail + tail_pos;
+	eocdr_offset = obj->disk_sizes[obj->number_of_disks-1] - tail_size + tail_pos;
+	start_disk = zip_load (eocdr + 6, 2);
+	tot_entries = zip_load (eocdr + 10, 2);
+	cd_size = zip_load (eocdr + 12, 4);
+	cd_offset = zip_load (eocdr + 16, 4);
+	fc_length = zip_load (eocdr + 20, 2);
 
-	obj->zip_file_comment = malloc (fc_length);
+	obj->zip_file_comment = malloc (fc_length + 1);
 	if (!obj->zip_file_comment)
-		return ZIP_OPEN_FAILURE;
-	if (fc_length != fread ((void*) obj->zip_file_comment, 1, fc_length, fp))
-		return ZIP_OPEN_FAILURE;
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	memcpy (obj->zip_file_comment, eocdr + ZIP_EOCDR_FIXED_PORTION_SIZE, fc_length);
 	obj->zip_file_comment[fc_length] = 0;
+	free (tail_buffer);
 
-	/* Go to the start of CD Central Directory */
+	/* A ZIP64 archive has its real counts, sizes and offsets in a ZIP64 End
+	   of Central Directory Record, found through the locator that comes
+	   right before the EOCDR */
+	if (eocdr_offset >= ZIP_EOCD64_LOCATOR_SIZE) {
+		const u8 *locator, *eocd64;
+		u8 locator_buffer[ZIP_EOCD64_LOCATOR_SIZE], eocd64_buffer[ZIP_EOCD64_FIXED_SIZE];
+		u32 eocd64_disk;
+		locator = zip_read_view (obj, obj->number_of_disks-1, eocdr_offset - ZIP_EOCD64_LOCATOR_SIZE,
+			ZIP_EOCD64_LOCATOR_SIZE, locator_buffer);
+		if (locator && zip_load (locator, 4) == ZIP_EOCD64_LOCATOR_SIGNATURE) {
+			eocd64_disk = zip_load (locator + 4, 4);
+			if (eocd64_disk >= obj->number_of_disks)
+				return ZIP_OPEN_FAILURE;
+			eocd64 = zip_read_view (obj, eocd64_disk, zip_load64 (locator + 8), ZIP_EOCD64_FIXED_SIZE, eocd64_buffer);
+			if (!eocd64 || zip_load (eocd64, 4) != ZIP_EOCD64_SIGNATURE)
+				return ZIP_OPEN_FAILURE;
+			start_disk = zip_load (eocd64 + 20, 4);
+			tot_entries = zip_load64 (eocd64 + 32);
+			cd_size = zip_load64 (eocd64 + 40);
+			cd_offset = zip_load64 (eocd64 + 48);
+		}
+	}
+
+	/* Use the Central Directory in place if it is all on one mapped disk,
+	   otherwise read it into memory, continuing at the start of the
+	   following disks if it spans more than one */
+	const u8* cd;
+	u8* cd_buffer;
+	u64 cd_read, available;
 	if (start_disk >= obj->number_of_disks)
 		return ZIP_OPEN_FAILURE;
 	if (cd_offset >= obj->disk_sizes[start_disk] - ZIP_CDFH_FIXED_SIZE)
 		return ZIP_OPEN_FAILURE;
-	if (fseek (obj->disks[start_disk], cd_offset, SEEK_SET))
+	available = 0;
+	for (u32 disk = start_disk; disk < obj->number_of_disks; disk++)
+		available += obj->disk_sizes[disk];
+	if (cd_size > available - cd_offset || tot_entries > cd_size / ZIP_CDFH_FIXED_SIZE)
 		return ZIP_OPEN_FAILURE;
 
-	/* Parse the Central Directory File Headers */
-	u32 disk;
-	cdfh temp, prev_temp;
-	disk = start_disk;
-	temp = NULL;
-	for (u16 i=0; i<tot_entries; i++) {
+	/* headers and their strings are counted and placed with u32, so a
+	   central directory that would not fit is refused, not truncated */
+	if (cd_size + 3 * tot_entries > 0xffffffffUL
+		|| tot_entries > ((size_t) -1 - (cd_size + 3 * tot_entries)) / sizeof (struct zip_central_directory_file_header)) {
+		fprintf (stderr, "zip_open_disk() central directory is too large.\n");
+		return ZIP_OPEN_FAILURE;
+	}
+	cd_buffer = NULL;
+	if (obj->maps[start_disk] && cd_size <= obj->disk_sizes[start_disk] - cd_offset) {
+		cd = obj->maps[start_disk] + cd_offset;
+		zip_advise (obj, start_disk, cd_offset, cd_size, ZIP_ADVICE_SEQUENTIAL);
+	}
+	else {
+		if (!(cd_buffer = malloc (cd_size + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		cd = cd_buffer;
+		cd_read = 0;
+		for (u32 disk = start_disk; cd_read < cd_size; disk++) {
+			u64 offset, length;
+			if (disk >= obj->number_of_disks) {
+				free (cd_buffer);
+				return ZIP_OPEN_FAILURE;
+			}
+			offset = (disk == start_disk) ? cd_offset : 0;
+			length = obj->disk_sizes[disk] - offset;
+			if (length > cd_size - cd_read)
+				length = cd_size - cd_read;
+			if (zip_read_at (obj, disk, offset, cd_buffer + cd_read, length)) {
+				free (cd_buffer);
+				return ZIP_OPEN_FAILURE;
+			}
+			cd_read += length;
+		}
+	}
 
-		/* save the prior header for building a linked list */
-		prev_temp = temp;
+	/* allocate the whole directory at once; the strings cannot be longer
+	   than the central directory itself */
+	zip_reserve (obj, tot_entries, cd_size + 3 * tot_entries);
 
-		/* determine if there is enough information on current disk */
-		if (disk >= obj->number_of_disks)
-			return ZIP_OPEN_FAILURE;
-		if (ftell (obj->disks[disk]) >= obj->disk_sizes[disk] - ZIP_CDFH_FIXED_SIZE)
-			return ZIP_OPEN_FAILURE;
+	/* Parse the Central Directory File Headers */
+	const u8* p;
+	cdfh temp;
+	p = cd;
+	for (u64 i=0; i<tot_entries; i++) {
 
-		/* if a CDFH Signature is found, allocate a new CDFH structure */
-		signature = zip_get_field (obj->disks[disk], ZIP_SIGNATURE_FIELD_SIZE);
-		if (signature != 0x02014b50)
-			return ZIP_OPEN_FAILURE;
-		temp = malloc (sizeof (struct zip_central_directory_file_header));
-		if (!temp) {
-			printf ("memory allocation error.\n");
-			exit (EXIT_FAILURE);
-		}
-
-		/* read the fields from disk into the CDFH structure */
-		u16 dummy;
-		dummy = zip_get_field (obj->disks[disk], 2);
-		temp->version = zip_get_field (obj->disks[disk], 2);
-		temp->bit_flag = zip_get_field (obj->disks[disk], 2);
-		temp->comp_method = zip_get_field (obj->disks[disk], 2);
-		dummy = zip_get_field (obj->disks[disk], 2);
-		dummy = zip_get_field (obj->disks[disk], 2);
-		temp->crc_32 = zip_get_field (obj->disks[disk], 4);
-		temp->comp_size = zip_get_field (obj->disks[disk], 4);
-		temp->uncomp_size = zip_get_field (obj->disks[disk], 4);
-		temp->fnl = zip_get_field (obj->disks[disk], 2);
-		temp->efl = zip_get_field (obj->disks[disk], 2);
-		temp->fcl = zip_get_field (obj->disks[disk], 2);
-		temp->disk = zip_get_field (obj->disks[disk], 2);
-		temp->int_attr = zip_get_field (obj->disks[disk], 2);
-		temp->ext_attr = zip_get_field (obj->disks[disk], 4);
-		temp->offset = zip_get_field (obj->disks[disk], 4);
-		if (!(temp->file_name = malloc (temp->fnl + 1)))
-			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
-		if (temp->fnl != fread (temp->file_name, 1, temp->fnl, obj->disks[disk]))
+		/* determine if there is enough information left */
+		if (p + ZIP_CDFH_FIXED_SIZE > cd + cd_size || zip_load (p, 4) != ZIP_CDFH_SIGNATURE) {
+			free (cd_buffer);
 			return ZIP_OPEN_FAILURE;
-		temp->file_name[temp->fnl] = 0;
-		if (!(temp->extra_field = malloc (temp->efl + 1)))
-			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
-		if (temp->efl != fread (temp->extra_field, 1, temp->efl, obj->disks[disk]))
-			return ZIP_OPEN_FAILURE;
-		temp->extra_field[temp->efl] = 0;
-		if (!(temp->file_comment = malloc (temp->fcl + 1)))
-			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
-		if (temp->fcl != fread (temp->file_comment, 1, temp->fcl, obj->disks[disk]))
-			return ZIP_OPEN_FAILURE;
-		temp->file_comment[temp->fcl] = 0;
-
-		/* if there is no more information on this disk, increment disks */
-		if (ftell (obj->disks[disk]) >= obj->disk_sizes[disk] - ZIP_CDFH_FIXED_SIZE)
-			disk++;
+		}
+		temp = &obj->central_dir[obj->total_cd_entries];
 
+		/* copy the fields into the CDFH structure */
+		temp->version_made_by = zip_load (p + 4, 2);
+		temp->version = zip_load (p + 6, 2);
+		temp->bit_flag = zip_load (p + 8, 2);
+		temp->comp_method = zip_load (p + 10, 2);
+		temp->mod_time = zip_load (p + 12, 2);
+		temp->mod_date = zip_load (p + 14, 2);
+		temp->crc_32 = zip_load (p + 16, 4);
+		temp->comp_size = zip_load (p + 20, 4);
+		temp->uncomp_size = zip_load (p + 24, 4);
+		temp->fnl = zip_load (p + 28, 2);
+		temp->efl = zip_load (p + 30, 2);
+		temp->fcl = zip_load (p + 32, 2);
+		temp->disk = zip_load (p + 34, 2);
+		temp->int_attr = zip_load (p + 36, 2);
+		temp->ext_attr = zip_load (p + 38, 4);
+		temp->offset = zip_load (p + 42, 4);
+		temp->data = NULL;
+		p += ZIP_CDFH_FIXED_SIZE;
 
-		/* append the temporary CDFH to the central_dir linked list */
-		if (!obj->central_dir) {
-			temp->prev_cdfh = NULL;
-			obj->central_dir = temp;
-			temp->next_cdfh = NULL;
-			obj->total_cd_entries++;
+		/* the strings go into the arena one after another */
+		if (p + temp->fnl + temp->efl + temp->fcl > cd + cd_size) {
+			free (cd_buffer);
+			return ZIP_OPEN_FAILURE;
 		}
-		else {
-			temp->prev_cdfh = prev_temp;
-			prev_temp->next_cdfh = temp;
-			temp->next_cdfh = NULL;
-			obj->total_cd_entries++;
+		temp->file_name = obj->arena_size;
+		temp->extra_field = temp->file_name + temp->fnl + 1;
+		temp->file_comment = temp->extra_field + temp->efl + 1;
+		obj->arena_size = temp->file_comment + temp->fcl + 1;
+		memcpy (obj->arena + temp->file_name, p, temp->fnl);
+		obj->arena[temp->file_name + temp->fnl] = 0;
+		p += temp->fnl;
+		memcpy (obj->arena + temp->extra_field, p, temp->efl);
+		obj->arena[temp->extra_field + temp->efl] = 0;
+		p += temp->efl;
+		memcpy (obj->arena + temp->file_comment, p, temp->fcl);
+		obj->arena[temp->file_comment + temp->fcl] = 0;
+		p += temp->fcl;
+
+		/* fields too large for the classic header are in the extra field */
+		if ((temp->uncomp_size == ZIP64_MARKER_32 || temp->comp_size == ZIP64_MARKER_32
+			|| temp->offset == ZIP64_MARKER_32 || temp->disk == ZIP64_MARKER_16)
+			&& zip_read_zip64_extra (temp, (const u8*) obj->arena + temp->extra_field)) {
+			free (cd_buffer);
+			return ZIP_OPEN_FAILURE;
 		}
-		
+		obj->total_cd_entries++;
+
 		/* continue to the next Central Directory File Header */
 	}
+	free (cd_buffer);
+
+	/* hash every name up front, unless the caller only needs a few */
+	if (obj->name_index_enabled)
+		zip_build_name_index (obj, obj->total_cd_entries);
 
 	return ZIP_OPEN_SUCCESS;
 }
@@ -301,12 +701,7 @@ char* zip_get_filename (struct zip_Object* obj, int n, char* dest, int size) {
 		return NULL;
 	}
 	else {
-		cdfh header_n;
-		header_n = obj->central_dir;
-		for (int i=0; i<n; i++)
-			header_n = header_n->next_cdfh;
-
-		strncpy (dest, header_n->file_name, size);
+		strncpy (dest, obj->arena + obj->central_dir[n].file_name, size);
 		dest[size-1] = 0;		
 		return dest;
 	}
@@ -314,32 +709,69 @@ char* zip_get_filename (struct zip_Object* obj, int n, char* dest, int size) {
 
 int zip_search_filename (struct zip_Object* obj, const char* fn) {
 	
-	cdfh header_i;
-	header_i = obj->central_dir;
-	for (int i=0; i< obj->total_cd_entries; i++) {
-		if (!strcmp (fn, header_i->file_name))
-			return i;
-		else
-			header_i = header_i->next_cdfh;
+	/* without an index, compare every name */
+	if (!obj->name_index) {
+		for (int i=0; i< obj->total_cd_entries; i++) {
+			if (!strcmp (fn, obj->arena + obj->central_dir[i].file_name))
+				return i;
+		}
+		return -1;
+	}
+
+	/* probe from the home slot until the name or an empty slot is found */
+	u32 hash, mask;
+	hash = zip_hash_name (fn);
+	mask = obj->name_index_size - 1;
+	for (u32 i = hash & mask; obj->name_index[i].entry; i = (i + 1) & mask) {
+		name_slot* slot = &obj->name_index[i];
+		if (slot->hash == hash && !strcmp (fn, obj->arena + obj->central_dir[slot->entry - 1].file_name))
+			return slot->entry - 1;
 	}
 	return -1;
 }
 
-unsigned long zip_get_file_length (struct zip_Object* obj, int n) {
+void zip_find_prefix (struct zip_Object* obj, const char* prefix, zip_iterator* it) {
+
+	/* names with the prefix are one contiguous run of the sorted index */
+	int length;
+	length = strlen (prefix);
+	it->next = zip_lower_bound (obj, prefix, length, 0);
+	it->end = zip_lower_bound (obj, prefix, length, 1);
+	it->pattern = NULL;
+}
+
+void zip_find_glob (struct zip_Object* obj, const char* pattern, zip_iterator* it) {
+
+	/* narrow the range to the literal part of the pattern before any
+	   wildcard, then match each name in it */
+	int length;
+	length = strcspn (pattern, "*?[");
+	it->next = zip_lower_bound (obj, pattern, length, 0);
+	it->end = zip_lower_bound (obj, pattern, length, 1);
+	it->pattern = pattern;
+}
+
+int zip_next (struct zip_Object* obj, zip_iterator* it) {
+	while (it->next < it->end) {
+		u32 n;
+		n = obj->sorted_index[it->next++];
+		if (!it->pattern || zip_glob_match (it->pattern, obj->arena + obj->central_dir[n].file_name))
+			return n;
+	}
+	return -1;
+}
+
+u64 zip_get_file_length (struct zip_Object* obj, int n) {
 	
 	if (n >= obj->total_cd_entries) {
 		return 0;
 	}
 	else {
-		cdfh header_n;
-		header_n = obj->central_dir;
-		for (int i=0; i<n; i++)
-			header_n = header_n->next_cdfh;
-		return header_n->uncomp_size;
+		return obj->central_dir[n].uncomp_size;
 	}
 }
 
-u32 zip_get_file_raw (struct zip_Object* obj, int n, u8** dest_ptr) {
+u64 zip_get_file_raw (struct zip_Object* obj, int n, u8** dest_ptr) {
 	
 	if (*dest_ptr) {
 		fprintf (stderr, "zip_get_file_raw() allocates memory for the destination; ");
@@ -348,7 +780,7 @@ u32 zip_get_file_raw (struct zip_Object* obj, int n, u8** dest_ptr) {
 	}
 	
 	/* check that n is in bounds and state is Ok */
-	if (obj->state != ZIP_STATE_CENTRAL_DIRECTORY_COMPLETE) {
+	if (obj->state == ZIP_STATE_WITHOUT_FORM) {
 		printf ("zip_get_file_raw() error: central directory is not complete;");
 		printf (" it cannot be parsed.\n");
 		exit (EXIT_FAILURE);
@@ -356,97 +788,44 @@ u32 zip_get_file_raw (struct zip_Object* obj, int n, u8** dest_ptr) {
 	if (n >= obj->total_cd_entries)
 		return 0;
 
-	/* make local copy of the central directory file record and position the file stream */
+	/* find the central directory file record for file n */
 	cdfh cdfh_n;
-	FILE* fstream;
-
-	cdfh_n = obj->central_dir;
-	for (int i=0; i<n; i++)
-		cdfh_n = cdfh_n->next_cdfh;
-	fstream = obj->disks[cdfh_n->disk];
-	if ((cdfh_n->disk) >= (obj->number_of_disks))
-		return 0;
-	if ((obj->disk_sizes[cdfh_n->disk]) <= (cdfh_n->offset + ZIP_LFH_FIXED_SIZE))
-		return 0;
-	if (fseek (fstream, cdfh_n->offset, SEEK_SET))
-		return 0;
-
-	/* parse the local file header */
-	u16 version, bit_flag, comp_method, fnl, efl;
-	u32 signature, crc_32, comp_size, uncomp_size;
-	
-	signature = zip_get_field (fstream, 4);
-	version = zip_get_field (fstream, 2);
-	bit_flag = zip_get_field (fstream, 2);
-	comp_method = zip_get_field (fstream, 2);
-	if (fseek (fstream, 4, SEEK_CUR))
-		return 0;
-	crc_32 = zip_get_field (fstream, 4);
-	comp_size = zip_get_field (fstream, 4);
-	uncomp_size = zip_get_field (fstream, 4);
-	fnl = zip_get_field (fstream, 2);
-	efl = zip_get_field (fstream, 2);
 
-	/* check for consistency between central dir and local file header */
-	int inconsistent;
+	cdfh_n = &obj->central_dir[n];
 
-	inconsistent = 0;
-	inconsistent |= (signature != 0x04034b50);
-	version = ((version > cdfh_n->version) ? version : cdfh_n->version);
-	inconsistent |= (comp_method != cdfh_n->comp_method);
-	if (bit_flag & ZIP_DATA_DESCRIPTOR_FLAG) {
-		/* if set, the crc_32, comp_size, and uncomp_size are set to zero
-		and the correct values are placed in a data descriptor after the data */
-		u32 dd_offset, first_field;
-		dd_offset = cdfh_n->offset + ZIP_LFH_FIXED_SIZE + fnl + efl + cdfh_n->comp_size;
-		if (fseek (fstream, dd_offset, SEEK_SET))
-			return 0;
-		first_field = zip_get_field (fstream, 4);
-		if (first_field == 0x08074b50) {
-			crc_32 = zip_get_field (fstream, 4);
-			comp_size = zip_get_field (fstream, 4);
-			uncomp_size = zip_get_field (fstream, 4);
-		}
-		else {
-			crc_32 = first_field;
-			comp_size = zip_get_field (fstream, 4);
-			uncomp_size = zip_get_field (fstream, 4);
-		}
-	}
-	inconsistent |= (crc_32 != cdfh_n->crc_32);
-	inconsistent |= (comp_size != cdfh_n->comp_size);
-	inconsistent |= (uncomp_size != cdfh_n->uncomp_size);
-	if (inconsistent) {
-		fprintf (stderr, "Central Directory and Local File Header are inconsistent.\n");
-		return 0;
+	/* appended files are still in memory */
+	if (cdfh_n->data) {
+		if (!(*dest_ptr = malloc (cdfh_n->comp_size + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		memcpy (*dest_ptr, cdfh_n->data, cdfh_n->comp_size);
+		return cdfh_n->comp_size;
 	}
 
-	/* position the file pointer to start of compressed data */
-	if (obj->disk_sizes[cdfh_n->disk] <= ftell (fstream) + fnl + efl)
-		return 0;
-	if (fseek (fstream, (cdfh_n->offset + ZIP_LFH_FIXED_SIZE + fnl + efl), SEEK_SET))
+	/* check the local file header and find the data after it */
+	u64 data_offset;
+	if (zip_locate_data (obj, cdfh_n, &data_offset))
 		return 0;
 
 	/* allocate destination buffer */
-	*dest_ptr = malloc (uncomp_size);
+	*dest_ptr = malloc (cdfh_n->comp_size + 1);
 	if (!(*dest_ptr)) {
 		printf ("ERROR: memory allocation failed in zip_get_file().\n");
 		exit (EXIT_FAILURE);
 	}
 
 	/* copy data to the dest buffer */
-	if (comp_size != fread ((*dest_ptr), 1, comp_size, fstream)) {
+	if (zip_read_at (obj, cdfh_n->disk, data_offset, *dest_ptr, cdfh_n->comp_size)) {
 		free (*(dest_ptr));
 		*dest_ptr = NULL;
 		fprintf (stderr, "in zip_get_file_raw(), fread() failed to get uncompressed data.\n");
 		return 0;
 	}
 	else {
-		return comp_size;
+		return cdfh_n->comp_size;
 	}
 }
 
-u32 zip_get_file (struct zip_Object* obj, int n, u8** dest_ptr)
+u64 zip_get_file (struct zip_Object* obj, int n, u8** dest_ptr)
 {
 	/* check that destination is not preallocated and that n is in bounds */
 	if (*dest_ptr) {
@@ -457,70 +836,1261 @@ u32 zip_get_file (struct zip_Object* obj, int n, u8** dest_ptr)
 	if (n >= obj->total_cd_entries)
 		return 0;
 
-	/* find the central directory file record for file n */
-	cdfh cdfh_n;
-	FILE* fstream;
-	cdfh_n = obj->central_dir;
-	for (int i=0; i<n; i++)
-		cdfh_n = cdfh_n->next_cdfh;
-
-	/* get the uncompressed data */
-	u8* src;
-	src = NULL;
-	if (cdfh_n->comp_size != zip_get_file_raw (obj, n, &src)) {
-		fprintf (stderr, "zip_get_file_raw() did not return expected uncomp_size.\n");
-		return 0;
+	/* with a cache, copy the cached data */
+	if (obj->cache_budget) {
+		const u8* data;
+		u64 size;
+		if (!(data = zip_get_file_cached (obj, n, &size)))
+			return 0;
+		if (!(*dest_ptr = malloc (size + 1))) {
+			fprintf (stderr, "failed to allocated dest_ptr.\n");
+			zip_release_file (obj, data);
+			return 0;
+		}
+		memcpy (*dest_ptr, data, size);
+		zip_release_file (obj, data);
+		return size;
 	}
 
-	/* allocate the destination buffer */
-	*dest_ptr = malloc (cdfh_n->uncomp_size);
+	/* allocate the destination buffer and decompress into it */
+	u64 uncomp_size;
+	uncomp_size = obj->central_dir[n].uncomp_size;
+	*dest_ptr = malloc (uncomp_size + 1);
 	if (!(*dest_ptr)) {
 		fprintf (stderr, "failed to allocated dest_ptr.\n");
 		return 0;
 	}
-
-	/* decompress the data */
-	if (cdfh_n->comp_method == ZIP_APPEND_NO_COMPRESSION) {
-		printf ("comp_method==ZIP_APPEND_NO_COMPRESSION\n");
+	if (zip_get_file_into (obj, n, *dest_ptr, uncomp_size) < 0) {
 		free (*dest_ptr);
-		*dest_ptr = src;
-		return cdfh_n->uncomp_size;
+		*dest_ptr = NULL;
+		return 0;
+	}
+	return uncomp_size;
+}
+
+long long zip_get_file_into (struct zip_Object* obj, int n, u8* dest, u64 dest_size) {
+
+	if (n < 0 || n >= obj->total_cd_entries)
+		return -1;
+	cdfh cdfh_n;
+	cdfh_n = &obj->central_dir[n];
+	if (cdfh_n->uncomp_size > dest_size) {
+		fprintf (stderr, "zip_get_file_into() destination is smaller than file %d.\n", n);
+		return -1;
+	}
+
+	/* get the compressed data without copying it where possible; data on
+	   a disk that is not mapped is read into a buffer private to this call */
+	const u8* src;
+	u8 stack_buffer[ZIP_STACK_READ_SIZE];
+	u8 *buffer, *heap_buffer;
+	buffer = NULL;
+	heap_buffer = NULL;
+	if (!cdfh_n->data && cdfh_n->disk < obj->number_of_disks && !obj->maps[cdfh_n->disk]) {
+		if (cdfh_n->comp_size <= ZIP_STACK_READ_SIZE)
+			buffer = stack_buffer;
+		else if (cdfh_n->comp_size > obj->disk_sizes[cdfh_n->disk]) {
+			fprintf (stderr, "zip_get_file_into() file %d is larger than its disk.\n", n);
+			return -1;
+		}
+		else if (!(buffer = heap_buffer = malloc (cdfh_n->comp_size)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	}
+	src = zip_entry_data (obj, cdfh_n, buffer);
+	if (!src) {
+		fprintf (stderr, "zip_get_file_into() could not read the data of file %d.\n", n);
+		free (heap_buffer);
+		return -1;
+	}
+	long long written;
+	written = zip_decode (obj, n, src, dest);
+	free (heap_buffer);
+	return written;
+}
+
+const u8* zip_get_file_cached (struct zip_Object* obj, int n, u64* size) {
+
+	if (n < 0 || n >= obj->total_cd_entries)
+		return NULL;
+
+	/* a hit is a table lookup */
+	cache_entry *entry, *other;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->cache_lock);
+#endif
+	if ((entry = zip_cache_find (obj, n))) {
+		obj->cache_hits++;
+		entry->refs++;
+		zip_cache_touch (obj, entry);
+	}
+	else
+		obj->cache_misses++;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_unlock (&obj->cache_lock);
+#endif
+	if (entry) {
+		*size = entry->size;
+		return ZIP_CACHE_DATA (entry);
+	}
+
+	/* on a miss, extract the file outside the lock; if another thread has
+	   cached it meanwhile, that copy is used instead */
+	u64 uncomp_size;
+	uncomp_size = obj->central_dir[n].uncomp_size;
+	if (!(entry = malloc (sizeof (cache_entry) + uncomp_size + 1))) {
+		fprintf (stderr, "zip_get_file_cached() could not allocate file %d.\n", n);
+		return NULL;
+	}
+	if (zip_get_file_into (obj, n, ZIP_CACHE_DATA (entry), uncomp_size) < 0) {
+		free (entry);
+		return NULL;
+	}
+	entry->n = n;
+	entry->size = uncomp_size;
+	entry->refs = 1;
+	entry->cached = 0;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->cache_lock);
+#endif
+	if ((other = zip_cache_find (obj, n))) {
+		free (entry);
+		entry = other;
+		entry->refs++;
+		zip_cache_touch (obj, entry);
+	}
+	else if (entry->size <= obj->cache_budget)
+		zip_cache_insert (obj, entry);
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_unlock (&obj->cache_lock);
+#endif
+	*size = entry->size;
+	return ZIP_CACHE_DATA (entry);
+}
+
+void zip_release_file (struct zip_Object* obj, const u8* data) {
+
+	cache_entry* entry;
+	int unused;
+	if (!data)
+		return;
+	entry = (cache_entry*) data - 1;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->cache_lock);
+#endif
+	unused = (--entry->refs == 0 && !entry->cached);
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_unlock (&obj->cache_lock);
+#endif
+	if (unused)
+		free (entry);
+}
+
+void zip_get_cache_stats (struct zip_Object* obj, zip_cache_stats* stats) {
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->cache_lock);
+#endif
+	stats->hits = obj->cache_hits;
+	stats->misses = obj->cache_misses;
+	stats->evictions = obj->cache_evictions;
+	stats->bytes = obj->cache_bytes;
+	stats->entries = obj->cache_entries;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_unlock (&obj->cache_lock);
+#endif
+}
+
+static long long zip_decode (struct zip_Object* obj, int n, const u8* src, u8* dest) {
+
+	/* decompress the data, checksumming it on the way when asked to */
+	cdfh cdfh_n;
+	long long written;
+	u32 crc;
+	cdfh_n = &obj->central_dir[n];
+	written = -1;
+	crc = cdfh_n->crc_32;
+	if (cdfh_n->comp_method == ZIP_APPEND_NO_COMPRESSION && cdfh_n->comp_size == cdfh_n->uncomp_size) {
+		TRACE_BLOCK ("comp_method==ZIP_APPEND_NO_COMPRESSION\n");
+		memcpy (dest, src, cdfh_n->uncomp_size);
+		written = cdfh_n->uncomp_size;
+		if (obj->verify_crc)
+			crc = zip_crc32 (dest, written);
 	}
 	else if (cdfh_n->comp_method == ZIP_APPEND_DEFLATE_COMPRESSION) {
-		if (cdfh_n->uncomp_size != 
-			comp_inflate (*dest_ptr, cdfh_n->uncomp_size, src, cdfh_n->comp_size)
-		) {
+		long long size;
+		size = zip_inflate (dest, cdfh_n->uncomp_size, src, cdfh_n->comp_size, obj->verify_crc ? &crc : NULL);
+		if (size < 0 || cdfh_n->uncomp_size != (u64) size)
 			fprintf (stderr, "in zip_get_file(), comp_inflate() did not return expected size");
-			free (src);
-			free (*dest_ptr);
-			*dest_ptr = NULL;
-			return 0;
-		}
-		else {
-			free (src);
-			return cdfh_n->uncomp_size;
-		}
+		else
+			written = cdfh_n->uncomp_size;
 	}
-	else {
+	else
 		fprintf (stderr, "zip file compression method not recognized.\n");
-		free (src);
-		free (*dest_ptr);
-		*dest_ptr = NULL;
+	if (written >= 0 && crc != cdfh_n->crc_32) {
+		fprintf (stderr, "file %d fails its CRC-32 check.\n", n);
+		return -1;
+	}
+	return written;
+}
+
+u64 zip_view_file_raw (struct zip_Object* obj, int n, const u8** view) {
+
+	*view = NULL;
+	if (n < 0 || n >= obj->total_cd_entries)
 		return 0;
+	*view = zip_entry_data (obj, &obj->central_dir[n], NULL);
+	return *view ? obj->central_dir[n].comp_size : 0;
+}
+
+long long zip_extract_stream (struct zip_Object* obj, int n, zip_stream_sink sink, void* ctx) {
+
+	if (n < 0 || n >= obj->total_cd_entries)
+		return -1;
+	cdfh cdfh_n;
+	cdfh_n = &obj->central_dir[n];
+	if (cdfh_n->comp_method != ZIP_APPEND_DEFLATE_COMPRESSION
+		&& !(cdfh_n->comp_method == ZIP_APPEND_NO_COMPRESSION && cdfh_n->comp_size == cdfh_n->uncomp_size)) {
+		fprintf (stderr, "zip file compression method not recognized.\n");
+		return -1;
+	}
+	u64 data_offset;
+	data_offset = 0;
+	if (!cdfh_n->data && zip_locate_data (obj, cdfh_n, &data_offset))
+		return -1;
+#ifdef ZIP_HAVE_PREAD
+	if (!cdfh_n->data)
+		posix_fadvise (fileno (obj->disks[cdfh_n->disk]), data_offset, cdfh_n->comp_size, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	/* Only one block of compressed data and one of output are held at a
+	   time, plus the inflater's window. The data is read through the file
+	   even where the disk is mapped, since touching the mapping would keep
+	   every page of a large file resident; stored data goes straight from
+	   the input block to the sink. */
+	u8 *in_buffer, *out_buffer;
+	comp_stream stream;
+	u64 fed, total;
+	u32 crc;
+	int got, failed;
+	in_buffer = malloc (ZIP_STREAM_CHUNK_SIZE);
+	out_buffer = malloc (ZIP_STREAM_CHUNK_SIZE);
+	if (!in_buffer || !out_buffer)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	stream = NULL;
+	if (cdfh_n->comp_method == ZIP_APPEND_DEFLATE_COMPRESSION)
+		comp_inflate_init (&stream);
+	fed = 0;
+	total = 0;
+	crc = 0;
+	failed = 0;
+	while (fed < cdfh_n->comp_size && !failed) {
+		const u8* in;
+		u32 chunk;
+		chunk = (cdfh_n->comp_size - fed > ZIP_STREAM_CHUNK_SIZE) ? ZIP_STREAM_CHUNK_SIZE : cdfh_n->comp_size - fed;
+		if (cdfh_n->data)
+			in = cdfh_n->data + fed;
+		else if (zip_read_file (obj, cdfh_n->disk, data_offset + fed, in_buffer, chunk)) {
+			failed = 1;
+			break;
+		}
+		else
+			in = in_buffer;
+		fed += chunk;
+		if (!stream) {
+			if (obj->verify_crc)
+				crc = comp_crc32 (crc, in, chunk);
+			total += chunk;
+			failed = (sink (in, chunk, ctx) != 0);
+			continue;
+		}
+		comp_inflate_feed (stream, in, chunk, fed == cdfh_n->comp_size);
+		while (!failed && (got = comp_inflate_drain (stream, out_buffer, ZIP_STREAM_CHUNK_SIZE)) > 0) {
+			if (obj->verify_crc)
+				crc = comp_crc32 (crc, out_buffer, got);
+			total += got;
+			failed = (sink (out_buffer, got, ctx) != 0);
+		}
+		failed |= (got < 0);
+	}
+	if (stream) {
+		failed |= !comp_inflate_finished (stream);
+		comp_inflate_end (&stream);
+	}
+	free (in_buffer);
+	free (out_buffer);
+
+	/* the sink has already had the data, so a bad check can only be reported */
+	if (failed)
+		return -1;
+	if (total != cdfh_n->uncomp_size) {
+		fprintf (stderr, "zip_extract_stream() file %d is not the size its header says.\n", n);
+		return -1;
 	}
+	if (obj->verify_crc && crc != cdfh_n->crc_32) {
+		fprintf (stderr, "zip_extract_stream() file %d fails its CRC-32 check.\n", n);
+		return -1;
+	}
+	return total;
 }
 
 void zip_remove_file (struct zip_Object* obj, int n) {
 
 }
 
-void zip_append_file (
+int zip_append_file (
 	struct zip_Object* obj,
+	const char* fn,
 	const unsigned char* raw,
 	int raw_size,
 	int comp_method
 ) {
 
+	if (comp_method != ZIP_APPEND_NO_COMPRESSION && comp_method != ZIP_APPEND_DEFLATE_COMPRESSION) {
+		fprintf (stderr, "zip_append_file() error: compression method not recognized.\n");
+		return -1;
+	}
+	u32 fnl;
+	fnl = strlen (fn);
+	if (raw_size < 0 || fnl > ZIP_MAX_FILENAME_LENGTH)
+		return -1;
+	if (obj->total_cd_entries >= ZIP64_MARKER_16)
+		return -1;
+
+	/* compress the data, keeping it stored if deflate does not make it smaller */
+	u8* data;
+	int data_size;
+	data = NULL;
+	data_size = raw_size;
+	if (comp_method == ZIP_APPEND_DEFLATE_COMPRESSION) {
+		int bound;
+		bound = comp_deflate_bound (raw_size);
+		if (bound >= 0 && !(data = malloc (bound)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		data_size = (bound >= 0) ? comp_deflate (data, bound, raw, raw_size, obj->deflate_level) : -1;
+		if (data_size < 0 || data_size >= raw_size) {
+			free (data);
+			data = NULL;
+			data_size = raw_size;
+			comp_method = ZIP_APPEND_NO_COMPRESSION;
+		}
+	}
+	if (!data) {
+		if (!(data = malloc (raw_size + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		memcpy (data, raw, raw_size);
+	}
+
+	/* make room for one more header, doubling the directory when full */
+	if (obj->total_cd_entries == obj->cd_capacity || obj->arena_size + fnl + 3 > obj->arena_capacity)
+		zip_reserve (obj, 2 * obj->cd_capacity + 1, 2 * obj->arena_capacity + fnl + 3);
+
+	/* fill in a new central directory file header */
+	cdfh temp;
+	time_t now;
+	struct tm* local;
+	temp = &obj->central_dir[obj->total_cd_entries];
+	now = time (NULL);
+	local = localtime (&now);
+	temp->version_made_by = ZIP_VERSION_MADE_BY;
+	temp->comp_method = comp_method;
+	temp->bit_flag = 0;
+	if (comp_method == ZIP_APPEND_NO_COMPRESSION)
+		temp->version = ZIP_VERSION_STORED;
+	else {
+		temp->version = ZIP_VERSION_DEFLATE;
+		if (obj->deflate_level >= COMP_DEFLATE_BEST - 1)
+			temp->bit_flag = ZIP_DEFLATE_MAXIMUM_FLAG;
+		else if (obj->deflate_level <= COMP_DEFLATE_FASTEST + 1)
+			temp->bit_flag = ZIP_DEFLATE_FAST_FLAG;
+	}
+	temp->mod_time = (local->tm_hour << 11) | (local->tm_min << 5) | (local->tm_sec / 2);
+	temp->mod_date = ((local->tm_year - 80) << 9) | ((local->tm_mon + 1) << 5) | local->tm_mday;
+	temp->crc_32 = comp_crc32 (0, raw, raw_size);
+	temp->comp_size = data_size;
+	temp->uncomp_size = raw_size;
+	temp->fnl = fnl;
+	temp->efl = 0;
+	temp->fcl = 0;
+	temp->disk = 0;
+	temp->int_attr = 0;
+	temp->ext_attr = 0;
+	temp->offset = 0;
+	temp->file_name = obj->arena_size;
+	temp->extra_field = temp->file_name + fnl + 1;
+	temp->file_comment = temp->extra_field + 1;
+	obj->arena_size = temp->file_comment + 1;
+	memcpy (obj->arena + temp->file_name, fn, fnl + 1);
+	obj->arena[temp->extra_field] = 0;
+	obj->arena[temp->file_comment] = 0;
+	temp->data = data;
+	obj->total_cd_entries++;
+
+	/* the sorted index is rebuilt on its next use */
+	free (obj->sorted_index);
+	obj->sorted_index = NULL;
+
+	/* keep the name index at most half full */
+	if (obj->name_index) {
+		if (2 * obj->total_cd_entries > obj->name_index_size)
+			zip_build_name_index (obj, 2 * obj->total_cd_entries);
+		else
+			zip_index_name (obj, obj->total_cd_entries - 1);
+	}
+	obj->state = ZIP_STATE_APPEND_FILES;
+	return obj->total_cd_entries - 1;
+}
+
+void zip_set_name_index (struct zip_Object* obj, int enable) {
+	if (obj->state != ZIP_STATE_WITHOUT_FORM) {
+		fprintf (stderr, "zip_set_name_index() must be called before zip_open_disk().\n");
+		return;
+	}
+	obj->name_index_enabled = enable;
+}
+
+void zip_set_mmap (struct zip_Object* obj, int enable) {
+	if (obj->number_of_disks) {
+		fprintf (stderr, "zip_set_mmap() must be called before zip_open_disk().\n");
+		return;
+	}
+	obj->mmap_enabled = enable;
+}
+
+void zip_set_deflate_level (struct zip_Object* obj, int level) {
+	if (level < COMP_DEFLATE_STORED || level > COMP_DEFLATE_BEST)
+		level = COMP_DEFLATE_DEFAULT;
+	obj->deflate_level = level;
+}
+
+void zip_set_verify_crc (struct zip_Object* obj, int enable) {
+	obj->verify_crc = enable;
+}
+
+void zip_set_cache (struct zip_Object* obj, u64 budget) {
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->cache_lock);
+#endif
+	obj->cache_budget = budget;
+	zip_cache_trim (obj);
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_unlock (&obj->cache_lock);
+#endif
+}
+
+int zip_write_disk (struct zip_Object* obj, const char* fn) {
+
+	/* only classic archives are written, so every count, size and offset
+	   must fit its classic field */
+	int too_large;
+	too_large = (obj->total_cd_entries >= ZIP64_MARKER_16);
+	for (u32 n=0; n<obj->total_cd_entries; n++)
+		too_large |= (obj->central_dir[n].comp_size >= ZIP64_MARKER_32 || obj->central_dir[n].uncomp_size >= ZIP64_MARKER_32);
+	if (too_large) {
+		fprintf (stderr, "zip_write_disk() cannot write an archive that needs ZIP64.\n");
+		return ZIP_WRITE_FAILURE;
+	}
+
+	FILE* fp;
+	fp = fopen (fn, "wb");
+	if (!fp)
+		return ZIP_WRITE_FAILURE;
+
+	/* write each local file header followed by its data; the new offsets
+	   are kept aside, since the directory still describes the open disks */
+	cdfh current;
+	u64 cd_offset, cd_size;
+	u64* offsets;
+	int failed;
+	if (!(offsets = malloc (obj->total_cd_entries * sizeof (u64) + 1)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	failed = 0;
+	for (int n=0; n<obj->total_cd_entries && !failed; n++) {
+		u8* data;
+		data = NULL;
+		current = &obj->central_dir[n];
+		if (current->comp_size != zip_get_file_raw (obj, n, &data)) {
+			failed = 1;
+			break;
+		}
+		/* the sizes go in the header, so no data descriptor follows */
+		offsets[n] = ftell (fp);
+		failed |= (offsets[n] >= ZIP64_MARKER_32);
+		failed |= zip_put_field (fp, ZIP_LFH_SIGNATURE, 4);
+		failed |= zip_put_field (fp, current->version, 2);
+		failed |= zip_put_field (fp, current->bit_flag & ~ZIP_DATA_DESCRIPTOR_FLAG, 2);
+		failed |= zip_put_field (fp, current->comp_method, 2);
+		failed |= zip_put_field (fp, current->mod_time, 2);
+		failed |= zip_put_field (fp, current->mod_date, 2);
+		failed |= zip_put_field (fp, current->crc_32, 4);
+		failed |= zip_put_field (fp, current->comp_size, 4);
+		failed |= zip_put_field (fp, current->uncomp_size, 4);
+		failed |= zip_put_field (fp, current->fnl, 2);
+		failed |= zip_put_field (fp, 0, 2);
+		failed |= (current->fnl != fwrite (obj->arena + current->file_name, 1, current->fnl, fp));
+		failed |= (current->comp_size != fwrite (data, 1, current->comp_size, fp));
+		free (data);
+	}
+
+	/* then the central directory */
+	cd_offset = ftell (fp);
+	for (int n=0; n<obj->total_cd_entries && !failed; n++) {
+		current = &obj->central_dir[n];
+		failed |= zip_put_field (fp, ZIP_CDFH_SIGNATURE, 4);
+		failed |= zip_put_field (fp, current->version_made_by, 2);
+		failed |= zip_put_field (fp, current->version, 2);
+		failed |= zip_put_field (fp, current->bit_flag & ~ZIP_DATA_DESCRIPTOR_FLAG, 2);
+		failed |= zip_put_field (fp, current->comp_method, 2);
+		failed |= zip_put_field (fp, current->mod_time, 2);
+		failed |= zip_put_field (fp, current->mod_date, 2);
+		failed |= zip_put_field (fp, current->crc_32, 4);
+		failed |= zip_put_field (fp, current->comp_size, 4);
+		failed |= zip_put_field (fp, current->uncomp_size, 4);
+		failed |= zip_put_field (fp, current->fnl, 2);
+		failed |= zip_put_field (fp, current->efl, 2);
+		failed |= zip_put_field (fp, current->fcl, 2);
+		failed |= zip_put_field (fp, 0, 2);
+		failed |= zip_put_field (fp, current->int_attr, 2);
+		failed |= zip_put_field (fp, current->ext_attr, 4);
+		failed |= zip_put_field (fp, offsets[n], 4);
+		failed |= (current->fnl != fwrite (obj->arena + current->file_name, 1, current->fnl, fp));
+		failed |= (current->efl != fwrite (obj->arena + current->extra_field, 1, current->efl, fp));
+		failed |= (current->fcl != fwrite (obj->arena + current->file_comment, 1, current->fcl, fp));
+	}
+	cd_size = ftell (fp) - cd_offset;
+	free (offsets);
+	failed |= (cd_offset >= ZIP64_MARKER_32 || cd_size >= ZIP64_MARKER_32);
+
+	/* and the End of Central Directory Record */
+	u16 fc_length;
+	fc_length = obj->zip_file_comment ? strlen (obj->zip_file_comment) : 0;
+	if (!failed) {
+		failed |= zip_put_field (fp, ZIP_EOCDR_SIGNATURE, 4);
+		failed |= zip_put_field (fp, 0, 2);
+		failed |= zip_put_field (fp, 0, 2);
+		failed |= zip_put_field (fp, obj->total_cd_entries, 2);
+		failed |= zip_put_field (fp, obj->total_cd_entries, 2);
+		failed |= zip_put_field (fp, cd_size, 4);
+		failed |= zip_put_field (fp, cd_offset, 4);
+		failed |= zip_put_field (fp, fc_length, 2);
+		if (fc_length)
+			failed |= (fc_length != fwrite (obj->zip_file_comment, 1, fc_length, fp));
+	}
+
+	failed |= (fclose (fp) != 0);
+	return failed ? ZIP_WRITE_FAILURE : ZIP_WRITE_SUCCESS;
+}
+
+int zip_extract_all (struct zip_Object* obj, int threads, zip_extract_callback callback, void* ctx) {
+	int* files;
+	int extracted;
+	if (!(files = malloc (obj->total_cd_entries * sizeof (int) + 1)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (int n=0; n<obj->total_cd_entries; n++)
+		files[n] = n;
+	extracted = zip_extract_set (obj, files, obj->total_cd_entries, threads, callback, ctx);
+	free (files);
+	return extracted;
+}
+
+int zip_extract_set (
+	struct zip_Object* obj,
+	const int* files,
+	int count,
+	int threads,
+	zip_extract_callback callback,
+	void* ctx
+) {
+
+	/* size the pool */
+#ifdef ZIP_HAVE_PREAD
+	if (threads <= 0)
+		threads = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+	threads = 1;
+#endif
+	if (threads > count)
+		threads = count;
+	if (threads < 1)
+		threads = 1;
+
+	/* sort the files by compressed size, largest first, keeping the
+	   local file number in the low half of the key */
+	u64* keys;
+	if (!(keys = malloc (count * sizeof (u64) + 1)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (int i=0; i<count; i++) {
+		u64 comp_size;
+		comp_size = (files[i] >= 0 && files[i] < obj->total_cd_entries) ? obj->central_dir[files[i]].comp_size : 0;
+		if (comp_size > 0xffffffffUL)
+			comp_size = 0xffffffffUL;
+		keys[i] = ((0xffffffffULL - comp_size) << 32) | (u32) files[i];
+	}
+	qsort (keys, count, sizeof (u64), zip_u64_cmp);
+
+	/* deal them out */
+	extract_pool pool;
+	extract_worker* workers;
+	int* slots;
+	int per_queue;
+	per_queue = (count + threads - 1) / threads;
+	pool.queues = malloc (threads * sizeof (extract_queue));
+	workers = malloc (threads * sizeof (extract_worker));
+	slots = malloc (threads * per_queue * sizeof (int) + 1);
+	if (!pool.queues || !workers || !slots)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (int q=0; q<threads; q++) {
+		pool.queues[q].files = slots + q * per_queue;
+		pool.queues[q].head = 0;
+		pool.queues[q].tail = 0;
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_init (&pool.queues[q].lock, NULL);
+#endif
+	}
+	for (int i=0; i<count; i++) {
+		extract_queue* queue = &pool.queues[i % threads];
+		queue->files[queue->tail++] = (int) (keys[i] & 0xffffffffUL);
+	}
+	free (keys);
+	pool.obj = obj;
+	pool.workers = threads;
+	pool.callback = callback;
+	pool.ctx = ctx;
+	pool.stop = 0;
+	pool.extracted = 0;
+
+	/* run the workers; this thread is worker 0 */
+#ifdef ZIP_HAVE_PREAD
+	pthread_t* ids;
+	int started;
+	pthread_mutex_init (&pool.lock, NULL);
+	if (!(ids = malloc (threads * sizeof (pthread_t))))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (started = 1; started < threads; started++) {
+		workers[started].pool = &pool;
+		workers[started].id = started;
+		if (pthread_create (&ids[started], NULL, zip_extract_work, &workers[started]))
+			break;
+	}
+	workers[0].pool = &pool;
+	workers[0].id = 0;
+	zip_extract_work (&workers[0]);
+	for (int i=1; i<started; i++)
+		pthread_join (ids[i], NULL);
+	free (ids);
+	pthread_mutex_destroy (&pool.lock);
+	for (int q=0; q<threads; q++)
+		pthread_mutex_destroy (&pool.queues[q].lock);
+#else
+	workers[0].pool = &pool;
+	workers[0].id = 0;
+	zip_extract_work (&workers[0]);
+#endif
+
+	free (slots);
+	free (workers);
+	free (pool.queues);
+	return pool.extracted;
+}
+
+int zip_extract_pipelined (
+	struct zip_Object* obj,
+	const int* files,
+	int count,
+	zip_extract_callback callback,
+	void* ctx
+) {
+
+	/* put the files in the order they are on the disks */
+	file_position* positions;
+	int* order;
+	positions = malloc (count * sizeof (file_position) + 1);
+	order = malloc (count * sizeof (int) + 1);
+	if (!positions || !order)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (int i=0; i<count; i++) {
+		positions[i].n = files[i];
+		positions[i].disk = 0xffffffffUL;
+		positions[i].offset = 0;
+		if (files[i] >= 0 && files[i] < obj->total_cd_entries && !obj->central_dir[files[i]].data) {
+			positions[i].disk = obj->central_dir[files[i]].disk;
+			positions[i].offset = obj->central_dir[files[i]].offset;
+		}
+	}
+	qsort (positions, count, sizeof (file_position), zip_position_cmp);
+	for (int i=0; i<count; i++)
+		order[i] = positions[i].n;
+	free (positions);
+
+	extract_pipeline pipeline;
+	pipeline.obj = obj;
+	pipeline.order = order;
+	pipeline.count = count;
+	for (int s=0; s<ZIP_PIPELINE_SLOTS; s++) {
+		pipeline.slots[s].buffer = NULL;
+		pipeline.slots[s].buffer_size = 0;
+	}
+	pipeline.read = 0;
+	pipeline.decoded = 0;
+	pipeline.stop = 0;
+
+	/* start the reading thread; without one, each file is read just
+	   before it is inflated */
+	int threaded;
+	threaded = 0;
+#ifdef ZIP_HAVE_PREAD
+	pthread_t reader;
+	pthread_mutex_init (&pipeline.lock, NULL);
+	pthread_cond_init (&pipeline.filled, NULL);
+	pthread_cond_init (&pipeline.emptied, NULL);
+	threaded = !pthread_create (&reader, NULL, zip_pipeline_read, &pipeline);
+#endif
+
+	/* inflate each file as it arrives, into one buffer grown to the largest */
+	u8* buffer;
+	u64 buffer_size;
+	int extracted;
+	buffer = NULL;
+	buffer_size = 0;
+	extracted = 0;
+	for (int i=0; i<count && !pipeline.stop; i++) {
+		pipeline_slot* slot;
+		long long size;
+		int stop;
+		slot = &pipeline.slots[i % ZIP_PIPELINE_SLOTS];
+		if (!threaded)
+			zip_pipeline_fill (obj, slot, order[i]);
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_lock (&pipeline.lock);
+		while (threaded && pipeline.read == i)
+			pthread_cond_wait (&pipeline.filled, &pipeline.lock);
+		pthread_mutex_unlock (&pipeline.lock);
+#endif
+		size = -1;
+		if (slot->data) {
+			if (obj->central_dir[slot->n].uncomp_size + 1 > buffer_size) {
+				free (buffer);
+				buffer_size = obj->central_dir[slot->n].uncomp_size + 1;
+				if (!(buffer = malloc (buffer_size)))
+					printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+			}
+			size = zip_decode (obj, slot->n, slot->data, buffer);
+		}
+		stop = callback (slot->n, (size < 0) ? NULL : buffer, (size < 0) ? 0 : size, ctx);
+		extracted += (size >= 0);
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_lock (&pipeline.lock);
+		pipeline.decoded++;
+		pipeline.stop |= stop;
+		pthread_cond_signal (&pipeline.emptied);
+		pthread_mutex_unlock (&pipeline.lock);
+#else
+		pipeline.stop |= stop;
+#endif
+	}
+
+#ifdef ZIP_HAVE_PREAD
+	if (threaded)
+		pthread_join (reader, NULL);
+	pthread_cond_destroy (&pipeline.emptied);
+	pthread_cond_destroy (&pipeline.filled);
+	pthread_mutex_destroy (&pipeline.lock);
+#endif
+	for (int s=0; s<ZIP_PIPELINE_SLOTS; s++)
+		free (pipeline.slots[s].buffer);
+	free (buffer);
+	free (order);
+	return extracted;
+}
+
+int zip_extract_batch (
+	struct zip_Object* obj,
+	const int* files,
+	int count,
+	zip_extract_callback callback,
+	void* ctx
+) {
+
+	/* Files on disks that are not mapped get a read each. Mapped disks are
+	   advised instead, so that the kernel pages them in meanwhile, and they
+	   and appended files are inflated once the reads are done. */
+	extract_batch batch;
+	batch_read* reads;
+	if (!(reads = malloc (count * sizeof (batch_read) + 1)) || !(batch.done = malloc (count * sizeof (int) + 1)))
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	batch.obj = obj;
+	batch.reads = reads;
+	batch.count = 0;
+	batch.callback = callback;
+	batch.ctx = ctx;
+	batch.buffer = NULL;
+	batch.buffer_size = 0;
+	batch.extracted = 0;
+	batch.stop = 0;
+	batch.next = 0;
+	batch.done_count = 0;
+	batch.taken = 0;
+	for (int i=0; i<count; i++) {
+		cdfh cdfh_n;
+		batch_read* read;
+		u64 length;
+		if (files[i] < 0 || files[i] >= obj->total_cd_entries)
+			continue;
+		cdfh_n = &obj->central_dir[files[i]];
+		if (cdfh_n->data || cdfh_n->disk >= obj->number_of_disks || cdfh_n->offset >= obj->disk_sizes[cdfh_n->disk])
+			continue;
+		length = ZIP_LFH_FIXED_SIZE + cdfh_n->fnl + cdfh_n->efl + ZIP_BATCH_SLACK;
+		length += (cdfh_n->comp_size < obj->disk_sizes[cdfh_n->disk]) ? cdfh_n->comp_size : obj->disk_sizes[cdfh_n->disk];
+		if (length > obj->disk_sizes[cdfh_n->disk] - cdfh_n->offset)
+			length = obj->disk_sizes[cdfh_n->disk] - cdfh_n->offset;
+		if (obj->maps[cdfh_n->disk]) {
+			zip_advise (obj, cdfh_n->disk, cdfh_n->offset, length, ZIP_ADVICE_WILLNEED);
+			continue;
+		}
+		read = &reads[batch.count++];
+		read->n = files[i];
+		read->disk = cdfh_n->disk;
+		read->offset = cdfh_n->offset;
+		read->length = length;
+		read->got = 0;
+		read->queued = 0;
+		read->buffer = NULL;
+	}
+
+	/* issue the reads through io_uring, or else a few reading threads */
+	int ringed;
+	ringed = 0;
+#ifdef ZIP_HAVE_IO_URING
+	uring ring;
+	if (batch.count && !zip_uring_setup (&ring)) {
+		ringed = 1;
+		zip_batch_uring (&batch, &ring);
+		zip_uring_close (&ring);
+	}
+#endif
+#ifdef ZIP_HAVE_PREAD
+	pthread_t ids[ZIP_BATCH_THREADS];
+	int started;
+	started = 0;
+	if (!ringed) {
+		pthread_mutex_init (&batch.lock, NULL);
+		pthread_cond_init (&batch.completed, NULL);
+		pthread_cond_init (&batch.taken_one, NULL);
+		for (started = 0; started < ZIP_BATCH_THREADS && started < batch.count; started++) {
+			if (pthread_create (&ids[started], NULL, zip_batch_work, &batch))
+				break;
+		}
+	}
+	while (!ringed && started && batch.taken < batch.count) {
+		int i;
+		pthread_mutex_lock (&batch.lock);
+		while (batch.taken == batch.done_count)
+			pthread_cond_wait (&batch.completed, &batch.lock);
+		i = batch.done[batch.taken++];
+		pthread_cond_signal (&batch.taken_one);
+		pthread_mutex_unlock (&batch.lock);
+		if (zip_batch_deliver (&batch, reads[i].n, zip_batch_data (obj, &reads[i]))) {
+			pthread_mutex_lock (&batch.lock);
+			batch.stop = 1;
+			pthread_cond_broadcast (&batch.taken_one);
+			pthread_mutex_unlock (&batch.lock);
+			break;
+		}
+		free (reads[i].buffer);
+		reads[i].buffer = NULL;
+	}
+	for (int i=0; i<started; i++)
+		pthread_join (ids[i], NULL);
+	if (!ringed) {
+		pthread_cond_destroy (&batch.taken_one);
+		pthread_cond_destroy (&batch.completed);
+		pthread_mutex_destroy (&batch.lock);
+	}
+	ringed |= started;
+#endif
+
+	/* without threads, read each file as it is inflated */
+	for (int i=0; !ringed && i<batch.count && !batch.stop; i++)
+		batch.stop |= zip_batch_deliver (&batch, reads[i].n, zip_batch_data (obj, &reads[i]));
+
+	/* then the files that needed no read, and any that cannot be found */
+	for (int i=0; i<count && !batch.stop; i++) {
+		cdfh cdfh_n;
+		if (files[i] < 0 || files[i] >= obj->total_cd_entries) {
+			batch.stop |= zip_batch_deliver (&batch, files[i], NULL);
+			continue;
+		}
+		cdfh_n = &obj->central_dir[files[i]];
+		if (cdfh_n->data || cdfh_n->disk >= obj->number_of_disks || cdfh_n->offset >= obj->disk_sizes[cdfh_n->disk])
+			batch.stop |= zip_batch_deliver (&batch, files[i], cdfh_n->data);
+		else if (obj->maps[cdfh_n->disk])
+			batch.stop |= zip_batch_deliver (&batch, files[i], zip_entry_data (obj, cdfh_n, NULL));
+	}
+
+	for (int i=0; i<batch.count; i++)
+		free (reads[i].buffer);
+	free (reads);
+	free (batch.done);
+	free (batch.buffer);
+	return batch.extracted;
+}
+
+static void* zip_extract_work (void* arg) {
+
+	/* each worker keeps one buffer, grown to the largest file it gets */
+	extract_worker* worker = arg;
+	extract_pool* pool = worker->pool;
+	u8* buffer;
+	u64 buffer_size;
+	int n;
+	buffer = NULL;
+	buffer_size = 0;
+	while (zip_extract_take (pool, worker->id, &n)) {
+		long long size;
+		int stop;
+		size = -1;
+		if (n >= 0 && n < pool->obj->total_cd_entries) {
+			if (pool->obj->central_dir[n].uncomp_size + 1 > buffer_size) {
+				free (buffer);
+				buffer_size = pool->obj->central_dir[n].uncomp_size + 1;
+				if (!(buffer = malloc (buffer_size)))
+					printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+			}
+			size = zip_get_file_into (pool->obj, n, buffer, buffer_size);
+		}
+		stop = pool->callback (n, (size < 0) ? NULL : buffer, (size < 0) ? 0 : size, pool->ctx);
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_lock (&pool->lock);
+#endif
+		pool->extracted += (size >= 0);
+		pool->stop |= stop;
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_unlock (&pool->lock);
+#endif
+	}
+	free (buffer);
+	return NULL;
+}
+
+static int zip_extract_take (extract_pool* pool, int id, int* n) {
+
+	/* a file number may be anything the caller gave, even negative, so
+	   whether one was taken is returned apart from it */
+	int stop, taken;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&pool->lock);
+	stop = pool->stop;
+	pthread_mutex_unlock (&pool->lock);
+#else
+	stop = pool->stop;
+#endif
+	if (stop)
+		return 0;
+
+	/* own queue first, then the others from the next worker on */
+	for (int i=0; i<pool->workers; i++) {
+		extract_queue* queue = &pool->queues[(id + i) % pool->workers];
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_lock (&queue->lock);
+#endif
+		taken = (queue->head < queue->tail);
+		if (taken)
+			*n = i ? queue->files[--queue->tail] : queue->files[queue->head++];
+#ifdef ZIP_HAVE_PREAD
+		pthread_mutex_unlock (&queue->lock);
+#endif
+		if (taken)
+			return 1;
+	}
+	return 0;
+}
+
+#ifdef ZIP_HAVE_PREAD
+static void* zip_pipeline_read (void* arg) {
+
+	/* wait for a free slot, fill it, and wake the inflating thread */
+	extract_pipeline* pipeline = arg;
+	for (int i=0; i<pipeline->count; i++) {
+		pthread_mutex_lock (&pipeline->lock);
+		while (!pipeline->stop && pipeline->read - pipeline->decoded == ZIP_PIPELINE_SLOTS)
+			pthread_cond_wait (&pipeline->emptied, &pipeline->lock);
+		if (pipeline->stop) {
+			pthread_mutex_unlock (&pipeline->lock);
+			break;
+		}
+		pthread_mutex_unlock (&pipeline->lock);
+		zip_pipeline_fill (pipeline->obj, &pipeline->slots[i % ZIP_PIPELINE_SLOTS], pipeline->order[i]);
+		pthread_mutex_lock (&pipeline->lock);
+		pipeline->read++;
+		pthread_cond_signal (&pipeline->filled);
+		pthread_mutex_unlock (&pipeline->lock);
+	}
+	return NULL;
+}
+#endif
+
+static void zip_pipeline_fill (struct zip_Object* obj, pipeline_slot* slot, int n) {
+
+	/* read through the file, so that the reading thread is the one that
+	   waits for the disk even where it is mapped */
+	cdfh cdfh_n;
+	u64 data_offset;
+	slot->n = n;
+	slot->data = NULL;
+	if (n < 0 || n >= obj->total_cd_entries)
+		return;
+	cdfh_n = &obj->central_dir[n];
+	if (cdfh_n->data) {
+		slot->data = cdfh_n->data;
+		return;
+	}
+	if (zip_locate_data (obj, cdfh_n, &data_offset))
+		return;
+	if (cdfh_n->comp_size + 1 > slot->buffer_size) {
+		free (slot->buffer);
+		slot->buffer_size = cdfh_n->comp_size + 1;
+		if (!(slot->buffer = malloc (slot->buffer_size)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	}
+	if (!zip_read_file (obj, cdfh_n->disk, data_offset, slot->buffer, cdfh_n->comp_size))
+		slot->data = slot->buffer;
+}
+
+static int zip_batch_deliver (extract_batch* batch, int n, const u8* src) {
+
+	/* inflate the file and hand it to the callback */
+	long long size;
+	size = -1;
+	if (src) {
+		if (batch->obj->central_dir[n].uncomp_size + 1 > batch->buffer_size) {
+			free (batch->buffer);
+			batch->buffer_size = batch->obj->central_dir[n].uncomp_size + 1;
+			if (!(batch->buffer = malloc (batch->buffer_size)))
+				printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		}
+		size = zip_decode (batch->obj, n, src, batch->buffer);
+	}
+	batch->extracted += (size >= 0);
+	return batch->callback (n, (size < 0) ? NULL : batch->buffer, (size < 0) ? 0 : size, batch->ctx);
+}
+
+static const u8* zip_batch_data (struct zip_Object* obj, batch_read* read) {
+
+	/* the local file header is checked by the usual means, which now only
+	   touches the page cache, and the part of the data past the end of the
+	   read, if any, is read now */
+	cdfh cdfh_n;
+	u64 data_offset, start, end;
+	cdfh_n = &obj->central_dir[read->n];
+	if (zip_locate_data (obj, cdfh_n, &data_offset))
+		return NULL;
+	start = data_offset - read->offset;
+	end = start + cdfh_n->comp_size;
+	if (end > read->got) {
+		u8* buffer;
+		if (!(buffer = realloc (read->buffer, end + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		read->buffer = buffer;
+		if (zip_read_file (obj, read->disk, read->offset + read->got, read->buffer + read->got, end - read->got))
+			return NULL;
+		read->got = end;
+	}
+	return read->buffer + start;
+}
+
+#ifdef ZIP_HAVE_PREAD
+static void* zip_batch_work (void* arg) {
+
+	/* take the next read, make it, and queue it for the inflating thread */
+	extract_batch* batch = arg;
+	for (;;) {
+		batch_read* read;
+		int i;
+		pthread_mutex_lock (&batch->lock);
+		while (!batch->stop && batch->next - batch->taken >= ZIP_BATCH_DEPTH)
+			pthread_cond_wait (&batch->taken_one, &batch->lock);
+		i = batch->stop ? batch->count : batch->next++;
+		pthread_mutex_unlock (&batch->lock);
+		if (i >= batch->count)
+			break;
+		read = &batch->reads[i];
+		if (read->length <= ZIP_BATCH_MAXIMUM_READ && !(read->buffer = malloc (read->length + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		if (read->buffer && !zip_read_file (batch->obj, read->disk, read->offset, read->buffer, read->length))
+			read->got = read->length;
+		pthread_mutex_lock (&batch->lock);
+		batch->done[batch->done_count++] = i;
+		pthread_cond_signal (&batch->completed);
+		pthread_mutex_unlock (&batch->lock);
+	}
+	return NULL;
+}
+#endif
+
+#ifdef ZIP_HAVE_IO_URING
+static int zip_uring_setup (uring* ring) {
+
+	/* map the submission queue, the completion queue and the entries */
+	struct io_uring_params params;
+	int fd;
+	memset (&params, 0, sizeof (params));
+	fd = syscall (__NR_io_uring_setup, ZIP_BATCH_DEPTH, &params);
+	if (fd < 0)
+		return 1;
+	ring->fd = fd;
+	ring->entries = params.sq_entries;
+	ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+	ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+	ring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_size > ring->sq_ring_size)
+			ring->sq_ring_size = ring->cq_ring_size;
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+	ring->sq_ring = mmap (NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+	ring->cq_ring = ring->sq_ring;
+	if (ring->sq_ring != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+		ring->cq_ring = mmap (NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+	ring->sqes = mmap (NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQES);
+	if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		if (ring->sqes != MAP_FAILED)
+			munmap (ring->sqes, ring->sqes_size);
+		if (ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+			munmap (ring->cq_ring, ring->cq_ring_size);
+		if (ring->sq_ring != MAP_FAILED)
+			munmap (ring->sq_ring, ring->sq_ring_size);
+		close (fd);
+		return 1;
+	}
+	ring->sq_head = (unsigned*) ((u8*) ring->sq_ring + params.sq_off.head);
+	ring->sq_tail = (unsigned*) ((u8*) ring->sq_ring + params.sq_off.tail);
+	ring->sq_mask = (unsigned*) ((u8*) ring->sq_ring + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned*) ((u8*) ring->sq_ring + params.sq_off.array);
+	ring->cq_head = (unsigned*) ((u8*) ring->cq_ring + params.cq_off.head);
+	ring->cq_tail = (unsigned*) ((u8*) ring->cq_ring + params.cq_off.tail);
+	ring->cq_mask = (unsigned*) ((u8*) ring->cq_ring + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*) ((u8*) ring->cq_ring + params.cq_off.cqes);
+	return 0;
+}
+
+static void zip_uring_close (uring* ring) {
+	munmap (ring->sqes, ring->sqes_size);
+	if (ring->cq_ring != ring->sq_ring)
+		munmap (ring->cq_ring, ring->cq_ring_size);
+	munmap (ring->sq_ring, ring->sq_ring_size);
+	close (ring->fd);
+}
+
+static void zip_batch_uring (extract_batch* batch, uring* ring) {
+
+	/* Keep the ring full and inflate each file as its read completes. A
+	   failed or short read is finished by zip_batch_data(), which also
+	   covers kernels without IORING_OP_READ. If the ring itself fails,
+	   reads still in flight are abandoned with their buffers. */
+	int next, inflight, delivered, broken;
+	unsigned tail, pending;
+	next = 0;
+	inflight = 0;
+	delivered = 0;
+	broken = 0;
+	pending = 0;
+	tail = *ring->sq_tail;
+	while (delivered < batch->count) {
+		while (!broken && !batch->stop && next < batch->count && inflight + pending < ring->entries) {
+			batch_read* read;
+			struct io_uring_sqe* sqe;
+			read = &batch->reads[next];
+			if (read->length > ZIP_BATCH_MAXIMUM_READ) {
+				batch->stop |= zip_batch_deliver (batch, read->n, zip_batch_data (batch->obj, read));
+				delivered++;
+				next++;
+				continue;
+			}
+			if (!(read->buffer = malloc (read->length + 1)))
+				printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+			sqe = &ring->sqes[tail & *ring->sq_mask];
+			memset (sqe, 0, sizeof (*sqe));
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = fileno (batch->obj->disks[read->disk]);
+			sqe->off = read->offset;
+			sqe->addr = (unsigned long) read->buffer;
+			sqe->len = read->length;
+			sqe->user_data = next;
+			read->queued = 1;
+			ring->sq_array[tail & *ring->sq_mask] = tail & *ring->sq_mask;
+			tail++;
+			pending++;
+			next++;
+		}
+		__atomic_store_n (ring->sq_tail, tail, __ATOMIC_RELEASE);
+		if (!broken && (pending || inflight)) {
+			int submitted;
+			submitted = syscall (__NR_io_uring_enter, ring->fd, pending, inflight + pending ? 1 : 0, IORING_ENTER_GETEVENTS, NULL, 0);
+			if (submitted >= 0) {
+				pending -= submitted;
+				inflight += submitted;
+			}
+			else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				broken = 1;
+		}
+
+		/* hand over whatever has completed */
+		unsigned head;
+		head = *ring->cq_head;
+		while (head != __atomic_load_n (ring->cq_tail, __ATOMIC_ACQUIRE)) {
+			struct io_uring_cqe* cqe;
+			batch_read* read;
+			cqe = &ring->cqes[head & *ring->cq_mask];
+			read = &batch->reads[cqe->user_data];
+			read->got = (cqe->res > 0) ? (u64) cqe->res : 0;
+			read->queued = 0;
+			head++;
+			__atomic_store_n (ring->cq_head, head, __ATOMIC_RELEASE);
+			inflight--;
+			if (!batch->stop)
+				batch->stop |= zip_batch_deliver (batch, read->n, zip_batch_data (batch->obj, read));
+			free (read->buffer);
+			read->buffer = NULL;
+			delivered++;
+		}
+		if (batch->stop && !inflight && !pending)
+			break;
+		if (broken) {
+			/* the remaining reads are made here, into new buffers, as the
+			   kernel may still write to those it was given */
+			for (int i=0; i<batch->count; i++) {
+				if (batch->reads[i].queued)
+					batch->reads[i].buffer = NULL;
+			}
+			for (int i=0; i<batch->count && !batch->stop; i++) {
+				batch_read* read;
+				read = &batch->reads[i];
+				if (!read->queued && i < next)
+					continue;
+				read->got = 0;
+				batch->stop |= zip_batch_deliver (batch, read->n, zip_batch_data (batch->obj, read));
+				free (read->buffer);
+				read->buffer = NULL;
+				read->queued = 0;
+			}
+			break;
+		}
+	}
+}
+#endif
+
+static int zip_position_cmp (const void* p1, const void* p2) {
+	const file_position *position1, *position2;
+	position1 = p1;
+	position2 = p2;
+	if (position1->disk != position2->disk)
+		return (position1->disk > position2->disk) - (position1->disk < position2->disk);
+	return (position1->offset > position2->offset) - (position1->offset < position2->offset);
+}
+
+static int zip_u64_cmp (const void* p1, const void* p2) {
+	u64 key1, key2;
+	key1 = *(const u64*) p1;
+	key2 = *(const u64*) p2;
+	return (key1 > key2) - (key1 < key2);
 }
 
 int zip_error_code (struct zip_Object* obj) {
@@ -531,19 +2101,540 @@ char* zip_error_name (int error_code, char* dest) {
 	return dest;
 }
 
-static u32 zip_get_field (FILE* fp, int field_size) {
-	u8 field[8];
-	u32 concat;
-	if (field_size > 8) {
-		printf ("zip_get_field() error: parameter field_size > 8.\n");
-		exit (EXIT_FAILURE);
+static void zip_reserve (struct zip_Object* obj, u32 headers, u32 arena_bytes) {
+
+	/* the headers and the arena share one allocation; growing it moves both,
+	   which is why headers refer to their strings by offset */
+	u8* block;
+	if (headers < obj->cd_capacity)
+		headers = obj->cd_capacity;
+	if (arena_bytes < obj->arena_capacity)
+		arena_bytes = obj->arena_capacity;
+	block = malloc (headers * sizeof (struct zip_central_directory_file_header) + arena_bytes + 1);
+	if (!block)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	if (obj->central_dir) {
+		memcpy (block, obj->central_dir, obj->total_cd_entries * sizeof (struct zip_central_directory_file_header));
+		memcpy (block + headers * sizeof (struct zip_central_directory_file_header), obj->arena, obj->arena_size);
+		free (obj->central_dir);
 	}
-	if (field_size != fread (field, 1, field_size, fp)) {
-		return 9999999999;
+	obj->central_dir = (cdfh) block;
+	obj->cd_capacity = headers;
+	obj->arena = (char*) (block + headers * sizeof (struct zip_central_directory_file_header));
+	obj->arena_capacity = arena_bytes;
+}
+
+static u32 zip_hash_name (const char* fn) {
+	/* 32-bit FNV-1a */
+	u32 hash;
+	hash = 2166136261UL;
+	while (*fn)
+		hash = ((hash ^ (u8) *fn++) * 16777619UL) & 0xffffffffUL;
+	return hash;
+}
+
+static void zip_build_name_index (struct zip_Object* obj, u32 entries) {
+
+	/* size the table to a power of two at least twice the entries */
+	u32 size;
+	for (size = 16; size < 2 * entries; size <<= 1)
+		;
+	free (obj->name_index);
+	obj->name_index = calloc (size, sizeof (name_slot));
+	if (!obj->name_index)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	obj->name_index_size = size;
+	for (u32 n=0; n<obj->total_cd_entries; n++)
+		zip_index_name (obj, n);
+}
+
+static void zip_index_name (struct zip_Object* obj, u32 n) {
+
+	/* a duplicate name keeps pointing at its first entry, as the linear
+	   search in zip_search_filename() would find */
+	const char* fn;
+	u32 hash, mask, i;
+	fn = obj->arena + obj->central_dir[n].file_name;
+	hash = zip_hash_name (fn);
+	mask = obj->name_index_size - 1;
+	for (i = hash & mask; obj->name_index[i].entry; i = (i + 1) & mask) {
+		name_slot* slot = &obj->name_index[i];
+		if (slot->hash == hash && !strcmp (fn, obj->arena + obj->central_dir[slot->entry - 1].file_name))
+			return;
 	}
-	concat = 0;
-	for (int i=0; i<field_size; i++) {
-		concat |= (field[i] << 8*i);
+	obj->name_index[i].hash = hash;
+	obj->name_index[i].entry = n + 1;
+}
+
+static void zip_build_sorted_index (struct zip_Object* obj) {
+
+	/* sort names with their local file numbers, then keep just the numbers */
+	sorted_name* names;
+	names = malloc (obj->total_cd_entries * sizeof (sorted_name) + 1);
+	obj->sorted_index = malloc (obj->total_cd_entries * sizeof (u32) + 1);
+	if (!names || !obj->sorted_index)
+		printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+	for (u32 n=0; n<obj->total_cd_entries; n++) {
+		names[n].name = obj->arena + obj->central_dir[n].file_name;
+		names[n].entry = n;
 	}
+	qsort (names, obj->total_cd_entries, sizeof (sorted_name), zip_sorted_cmp);
+	for (u32 i=0; i<obj->total_cd_entries; i++)
+		obj->sorted_index[i] = names[i].entry;
+	free (names);
+}
+
+static int zip_sorted_cmp (const void* p1, const void* p2) {
+	const sorted_name* a = p1;
+	const sorted_name* b = p2;
+	int order;
+	order = strcmp (a->name, b->name);
+	if (order)
+		return order;
+	return (a->entry > b->entry) - (a->entry < b->entry);
+}
+
+static u32 zip_lower_bound (struct zip_Object* obj, const char* prefix, int length, int past) {
+
+	/* binary search for the first name whose first length characters
+	   compare at or after the prefix (or strictly after it, when past) */
+	u32 low, high;
+#ifdef ZIP_HAVE_PREAD
+	pthread_mutex_lock (&obj->sorted_index_lock);
+	if (!obj->sorted_index)
+		zip_build_sorted_index (obj);
+	pthread_mutex_unlock (&obj->sorted_index_lock);
+#else
+	if (!obj->sorted_index)
+		zip_build_sorted_index (obj);
+#endif
+	low = 0;
+	high = obj->total_cd_entries;
+	while (low < high) {
+		u32 mid;
+		int order;
+		mid = low + (high - low) / 2;
+		order = strncmp (obj->arena + obj->central_dir[obj->sorted_index[mid]].file_name, prefix, length);
+		if (order < 0 || (past && order == 0))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+static int zip_glob_match (const char* pattern, const char* name) {
+
+	/* '*' matches any run of characters, '/' included, '?' any single
+	   character, and [...] one of a set with ranges and a leading '!';
+	   on a mismatch, retry from the last '*' one character further on */
+	const char *star_pattern, *star_name;
+	star_pattern = NULL;
+	star_name = NULL;
+	while (*name) {
+		if (*pattern == '*') {
+			star_pattern = ++pattern;
+			star_name = name;
+			continue;
+		}
+		if (*pattern == '[') {
+			const char *p, *first;
+			int negate, matched;
+			p = pattern + 1;
+			negate = (*p == '!');
+			p += negate;
+			first = p;
+			matched = 0;
+
+			/* a ']' first in the set is a member; the pattern may end
+			   before the set does */
+			while (*p && (*p != ']' || p == first)) {
+				if (p[1] == '-' && p[2] && p[2] != ']') {
+					matched |= ((u8) *name >= (u8) p[0] && (u8) *name <= (u8) p[2]);
+					p += 3;
+				}
+				else
+					matched |= (*name == *p++);
+			}
+			if (*p == ']' && matched != negate) {
+				pattern = p + 1;
+				name++;
+				continue;
+			}
+
+			/* without its ']', the '[' is an ordinary character */
+			if (*p != ']' && *name == '[') {
+				pattern++;
+				name++;
+				continue;
+			}
+		}
+		else if (*pattern && (*pattern == '?' || *pattern == *name)) {
+			pattern++;
+			name++;
+			continue;
+		}
+		if (!star_pattern)
+			return 0;
+		pattern = star_pattern;
+		name = ++star_name;
+	}
+	while (*pattern == '*')
+		pattern++;
+	return !*pattern;
+}
+
+static cache_entry* zip_cache_find (struct zip_Object* obj, int n) {
+
+	cache_entry* entry;
+	if (!obj->cache_table_size)
+		return NULL;
+	for (entry = obj->cache_table[n & (obj->cache_table_size - 1)]; entry; entry = entry->chain) {
+		if (entry->n == n)
+			return entry;
+	}
+	return NULL;
+}
+
+static void zip_cache_touch (struct zip_Object* obj, cache_entry* entry) {
+
+	if (!entry->cached || obj->cache_newest == entry)
+		return;
+
+	/* unlink it, then put it at the newest end */
+	entry->newer->older = entry->older;
+	if (entry->older)
+		entry->older->newer = entry->newer;
+	else
+		obj->cache_oldest = entry->newer;
+	entry->newer = NULL;
+	entry->older = obj->cache_newest;
+	obj->cache_newest->newer = entry;
+	obj->cache_newest = entry;
+}
+
+static void zip_cache_insert (struct zip_Object* obj, cache_entry* entry) {
+
+	/* keep at most one entry per slot on average; local file numbers are
+	   consecutive, so their low bits spread them evenly */
+	if (obj->cache_entries >= obj->cache_table_size) {
+		cache_entry** table;
+		u32 size;
+		size = obj->cache_table_size ? 2 * obj->cache_table_size : ZIP_CACHE_MINIMUM_TABLE;
+		if (!(table = calloc (size, sizeof (cache_entry*))))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		for (u32 i=0; i<obj->cache_table_size; i++) {
+			while (obj->cache_table[i]) {
+				cache_entry* moved = obj->cache_table[i];
+				obj->cache_table[i] = moved->chain;
+				moved->chain = table[moved->n & (size - 1)];
+				table[moved->n & (size - 1)] = moved;
+			}
+		}
+		free (obj->cache_table);
+		obj->cache_table = table;
+		obj->cache_table_size = size;
+	}
+	entry->chain = obj->cache_table[entry->n & (obj->cache_table_size - 1)];
+	obj->cache_table[entry->n & (obj->cache_table_size - 1)] = entry;
+	entry->cached = 1;
+	entry->newer = NULL;
+	entry->older = obj->cache_newest;
+	if (obj->cache_newest)
+		obj->cache_newest->newer = entry;
+	else
+		obj->cache_oldest = entry;
+	obj->cache_newest = entry;
+	obj->cache_entries++;
+	obj->cache_bytes += entry->size;
+	zip_cache_trim (obj);
+}
+
+static void zip_cache_evict (struct zip_Object* obj, cache_entry* entry) {
+
+	/* take it out of the table and the list, freeing it unless referenced */
+	cache_entry** link;
+	for (link = &obj->cache_table[entry->n & (obj->cache_table_size - 1)]; *link != entry; link = &(*link)->chain)
+		;
+	*link = entry->chain;
+	if (entry->newer)
+		entry->newer->older = entry->older;
+	else
+		obj->cache_newest = entry->older;
+	if (entry->older)
+		entry->older->newer = entry->newer;
+	else
+		obj->cache_oldest = entry->newer;
+	entry->cached = 0;
+	obj->cache_entries--;
+	obj->cache_bytes -= entry->size;
+	obj->cache_evictions++;
+	if (!entry->refs)
+		free (entry);
+}
+
+static void zip_cache_trim (struct zip_Object* obj) {
+	while (obj->cache_bytes > obj->cache_budget || (obj->cache_entries && !obj->cache_budget))
+		zip_cache_evict (obj, obj->cache_oldest);
+}
+
+static int zip_read_zip64_extra (cdfh cdfh_n, const u8* extra) {
+
+	/* The extra field is a run of blocks, each an id, a size and the data.
+	   The ZIP64 block has, in this order, only those of the uncompressed
+	   size, compressed size, offset and disk whose classic field is marked. */
+	u32 pos, id, size, need;
+	for (pos = 0; pos + 4 <= cdfh_n->efl; pos += 4 + size) {
+		id = zip_load (extra + pos, 2);
+		size = zip_load (extra + pos + 2, 2);
+		if (pos + 4 + size > cdfh_n->efl)
+			return 1;
+		if (id != ZIP64_EXTRA_FIELD_ID)
+			continue;
+		need = 8 * (cdfh_n->uncomp_size == ZIP64_MARKER_32) + 8 * (cdfh_n->comp_size == ZIP64_MARKER_32)
+			+ 8 * (cdfh_n->offset == ZIP64_MARKER_32) + 4 * (cdfh_n->disk == ZIP64_MARKER_16);
+		if (size < need)
+			return 1;
+		extra += pos + 4;
+		if (cdfh_n->uncomp_size == ZIP64_MARKER_32)
+			cdfh_n->uncomp_size = zip_load64 (extra), extra += 8;
+		if (cdfh_n->comp_size == ZIP64_MARKER_32)
+			cdfh_n->comp_size = zip_load64 (extra), extra += 8;
+		if (cdfh_n->offset == ZIP64_MARKER_32)
+			cdfh_n->offset = zip_load64 (extra), extra += 8;
+		if (cdfh_n->disk == ZIP64_MARKER_16)
+			cdfh_n->disk = zip_load (extra, 4);
+		return 0;
+	}
+	return 1;
+}
+
+static int zip_locate_data (struct zip_Object* obj, cdfh cdfh_n, u64* data_offset_ptr) {
+
+	/* the local file header must fit on the header's disk */
+	const u8* lfh;
+	u8 lfh_buffer[ZIP_LFH_FIXED_SIZE];
+	u64 disk_size;
+	if ((cdfh_n->disk) >= (obj->number_of_disks))
+		return 1;
+	disk_size = obj->disk_sizes[cdfh_n->disk];
+	if (disk_size <= ZIP_LFH_FIXED_SIZE || cdfh_n->offset >= disk_size - ZIP_LFH_FIXED_SIZE)
+		return 1;
+	lfh = zip_read_view (obj, cdfh_n->disk, cdfh_n->offset, ZIP_LFH_FIXED_SIZE, lfh_buffer);
+	if (!lfh)
+		return 1;
+
+	/* parse the local file header */
+	u16 bit_flag, comp_method, fnl, efl;
+	u32 signature, crc_32;
+	u64 comp_size, uncomp_size, data_offset;
+	signature = zip_load (lfh, 4);
+	bit_flag = zip_load (lfh + 6, 2);
+	comp_method = zip_load (lfh + 8, 2);
+	crc_32 = zip_load (lfh + 14, 4);
+	comp_size = zip_load (lfh + 18, 4);
+	uncomp_size = zip_load (lfh + 22, 4);
+	fnl = zip_load (lfh + 26, 2);
+	efl = zip_load (lfh + 28, 2);
+	data_offset = cdfh_n->offset + ZIP_LFH_FIXED_SIZE + fnl + efl;
+
+	/* check for consistency between central dir and local file header */
+	int inconsistent, zip64;
+	inconsistent = 0;
+	inconsistent |= (signature != ZIP_LFH_SIGNATURE);
+	inconsistent |= (comp_method != cdfh_n->comp_method);
+
+	/* marked sizes are in the ZIP64 block of the local extra field */
+	zip64 = (comp_size == ZIP64_MARKER_32 || uncomp_size == ZIP64_MARKER_32);
+	if (zip64 && !inconsistent) {
+		struct zip_central_directory_file_header local;
+		const u8* extra;
+		u8* extra_buffer;
+		local.uncomp_size = uncomp_size;
+		local.comp_size = comp_size;
+		local.offset = 0;
+		local.disk = 0;
+		local.efl = efl;
+		extra_buffer = NULL;
+		if (!obj->maps[cdfh_n->disk] && !(extra_buffer = malloc (efl + 1)))
+			printf ("memory allocation error.\n"), exit (EXIT_FAILURE);
+		extra = zip_read_view (obj, cdfh_n->disk, data_offset - efl, efl, extra_buffer);
+		inconsistent |= (!extra || zip_read_zip64_extra (&local, extra));
+		free (extra_buffer);
+		comp_size = local.comp_size;
+		uncomp_size = local.uncomp_size;
+	}
+
+	if (bit_flag & ZIP_DATA_DESCRIPTOR_FLAG) {
+		/* if set, the crc_32, comp_size, and uncomp_size are set to zero
+		and the correct values are placed in a data descriptor after the data;
+		its sizes are 8 bytes each when the local header is ZIP64 */
+		const u8* dd;
+		u8 dd_buffer[24];
+		u64 dd_offset, dd_length;
+		dd_length = zip64 ? 20 : 12;
+		if (cdfh_n->comp_size > disk_size)
+			return 1;
+		dd_offset = data_offset + cdfh_n->comp_size;
+		if (dd_offset + dd_length > disk_size)
+			return 1;
+		dd = zip_read_view (obj, cdfh_n->disk, dd_offset,
+			(dd_offset + dd_length + 4 <= disk_size) ? dd_length + 4 : dd_length, dd_buffer);
+		if (!dd)
+			return 1;
+		if (zip_load (dd, 4) == 0x08074b50 && dd_offset + dd_length + 4 <= disk_size)
+			dd += 4;
+		crc_32 = zip_load (dd, 4);
+		comp_size = zip64 ? zip_load64 (dd + 4) : zip_load (dd + 4, 4);
+		uncomp_size = zip64 ? zip_load64 (dd + 12) : zip_load (dd + 8, 4);
+	}
+	inconsistent |= (crc_32 != cdfh_n->crc_32);
+	inconsistent |= (comp_size != cdfh_n->comp_size);
+	inconsistent |= (uncomp_size != cdfh_n->uncomp_size);
+	if (inconsistent) {
+		fprintf (stderr, "Central Directory and Local File Header are inconsistent.\n");
+		return 1;
+	}
+
+	/* the compressed data must fit on the disk too */
+	if (data_offset > disk_size || comp_size > disk_size - data_offset)
+		return 1;
+	*data_offset_ptr = data_offset;
+	return 0;
+}
+
+static const u8* zip_entry_data (struct zip_Object* obj, cdfh cdfh_n, u8* buffer) {
+
+	/* appended files are in memory and mapped disks are read in place */
+	u64 data_offset;
+	if (cdfh_n->data)
+		return cdfh_n->data;
+	if (zip_locate_data (obj, cdfh_n, &data_offset))
+		return NULL;
+	if (obj->maps[cdfh_n->disk]) {
+		zip_advise (obj, cdfh_n->disk, data_offset, cdfh_n->comp_size, ZIP_ADVICE_WILLNEED);
+		return obj->maps[cdfh_n->disk] + data_offset;
+	}
+	if (!buffer || zip_read_at (obj, cdfh_n->disk, data_offset, buffer, cdfh_n->comp_size))
+		return NULL;
+	return buffer;
+}
+
+static long long zip_inflate (u8* dest, u64 dest_size, const u8* src, u64 src_size, u32* crc) {
+
+	/* comp_inflate() takes int sizes, so larger files are streamed through
+	   a comp_stream a chunk at a time; crc is NULL to skip the check */
+	if (dest_size <= INT_MAX && src_size <= INT_MAX) {
+		if (crc)
+			return comp_inflate_crc (dest, dest_size, src, src_size, crc);
+		return comp_inflate (dest, dest_size, src, src_size);
+	}
+	comp_stream stream;
+	u64 fed, written;
+	int got, failed;
+	comp_inflate_init (&stream);
+	if (crc)
+		*crc = 0;
+	fed = 0;
+	written = 0;
+	got = 0;
+	while (fed < src_size && got >= 0) {
+		u64 chunk;
+		chunk = (src_size - fed > ZIP_INFLATE_CHUNK_SIZE) ? ZIP_INFLATE_CHUNK_SIZE : src_size - fed;
+		comp_inflate_feed (stream, src + fed, chunk, fed + chunk == src_size);
+		fed += chunk;
+		do {
+			chunk = (dest_size - written > ZIP_INFLATE_CHUNK_SIZE) ? ZIP_INFLATE_CHUNK_SIZE : dest_size - written;
+			got = comp_inflate_drain (stream, dest + written, chunk);
+			if (got > 0 && crc)
+				*crc = comp_crc32 (*crc, dest + written, got);
+			written += (got > 0) ? got : 0;
+		} while (got > 0);
+	}
+
+	/* a stream that ends early or never ends is an error too */
+	failed = (got < 0) || !comp_inflate_finished (stream);
+	comp_inflate_end (&stream);
+	return failed ? -1 : (long long) written;
+}
+
+static u32 zip_crc32 (const u8* data, u64 size) {
+	/* comp_crc32() takes an int size */
+	u32 crc;
+	crc = 0;
+	for (u64 done = 0; done < size; done += ZIP_INFLATE_CHUNK_SIZE)
+		crc = comp_crc32 (crc, data + done, (size - done > ZIP_INFLATE_CHUNK_SIZE) ? ZIP_INFLATE_CHUNK_SIZE : size - done);
+	return crc;
+}
+
+static int zip_read_at (struct zip_Object* obj, u32 disk, u64 offset, u8* dest, u64 length) {
+	if (offset > obj->disk_sizes[disk] || length > obj->disk_sizes[disk] - offset)
+		return 1;
+	if (obj->maps[disk]) {
+		memcpy (dest, obj->maps[disk] + offset, length);
+		return 0;
+	}
+	return zip_read_file (obj, disk, offset, dest, length);
+}
+
+static int zip_read_file (struct zip_Object* obj, u32 disk, u64 offset, u8* dest, u64 length) {
+#ifdef ZIP_HAVE_PREAD
+	/* positional reads leave the shared file position alone */
+	while (length) {
+		ssize_t got;
+		got = pread (fileno (obj->disks[disk]), dest, length, offset);
+		if (got <= 0)
+			return 1;
+		dest += got;
+		offset += got;
+		length -= got;
+	}
+	return 0;
+#else
+	if (fseek (obj->disks[disk], offset, SEEK_SET))
+		return 1;
+	return length != fread (dest, 1, length, obj->disks[disk]);
+#endif
+}
+
+static const u8* zip_read_view (struct zip_Object* obj, u32 disk, u64 offset, u64 length, u8* scratch) {
+	/* mapped disks need no copy */
+	if (offset > obj->disk_sizes[disk] || length > obj->disk_sizes[disk] - offset)
+		return NULL;
+	if (obj->maps[disk])
+		return obj->maps[disk] + offset;
+	return zip_read_at (obj, disk, offset, scratch, length) ? NULL : scratch;
+}
+
+static void zip_advise (struct zip_Object* obj, u32 disk, u64 offset, u64 length, int advice) {
+#ifdef ZIP_HAVE_MMAP
+	/* the advice applies to whole pages */
+	u64 page, start;
+	if (!obj->maps[disk] || !length)
+		return;
+	page = sysconf (_SC_PAGESIZE);
+	start = offset - offset % page;
+	posix_madvise (obj->maps[disk] + start, offset + length - start, advice);
+#endif
+}
+
+static u32 zip_load (const u8* p, int field_size) {
+	/* little-endian field at any alignment */
+	u32 concat;
+	concat = 0;
+	for (int i=0; i<field_size; i++)
+		concat |= (u32) p[i] << 8*i;
 	return concat;
 }
+
+static u64 zip_load64 (const u8* p) {
+	return (u64) zip_load (p, 4) | (u64) zip_load (p + 4, 4) << 32;
+}
+
+static int zip_put_field (FILE* fp, u32 value, int field_size) {
+	/* little-endian, like zip_load(); returns nonzero on failure */
+	u8 field[8];
+	for (int i=0; i<field_size; i++)
+		field[i] = value >> 8*i;
+	return field_size != fwrite (field, 1, field_size, fp);
+}
@@ -1,7 +1,10 @@
 #ifndef ZIP_H
 #define ZIP_H
 /******************************************************************************
- *                                                                            *
+ * Once zip_open_disk() has found the central directory, the functions that   *
+ * only read the archive may be called from many threads on one object at     *
+ * once. zip_append_file(), zip_write_disk() and the zip_set_...() functions  *
+ * must not run at the same time as any other call on the object.             *
  ******************************************************************************/
 
 typedef struct zip_Object* zip_object;
@@ -9,6 +12,28 @@ typedef struct zip_Object* zip_object;
 void zip_constructor (zip_object*);
 void zip_destructor (zip_object*);
 
+void zip_set_name_index (zip_object, int);                                    /*
+      @param: nonzero (the default) to hash every filename when the central
+              directory is opened, making zip_search_filename() O(1); zero
+              to skip it for objects that search once or not at all.
+              Call before zip_open_disk().                                    */
+
+void zip_set_mmap (zip_object, int);                                          /*
+      @param: nonzero (the default) to memory map each disk where the
+              platform allows, falling back to stdio when mapping fails;
+              zero to always use stdio. Call before zip_open_disk().          */
+
+void zip_set_verify_crc (zip_object, int);                                    /*
+      @param: nonzero to check the CRC-32 of every file that is extracted,
+              failing the extraction on a mismatch; zero (the default) to
+              trust the data. The check runs as the data is decompressed.     */
+
+void zip_set_cache (zip_object, unsigned long long);                          /*
+      @param: budget in bytes for keeping extracted files, which
+              zip_get_file_cached() and zip_get_file() then reuse; the least
+              recently used are evicted past it. 0 (the default) disables
+              the cache and empties it.                                       */
+
 #define ZIP_OPEN_SUCCESS 1
 #define ZIP_OPEN_NEED_ADDITIONAL_DISK -1
 #define ZIP_OPEN_FAILURE 0
@@ -23,28 +48,144 @@ char* zip_get_filename (zip_object, int, char*, int);                         /*
 int zip_search_filename (zip_object, const char*);                            /*
       return: local file number n, or -1 if filename not found                */
 
-unsigned long zip_get_file_length (zip_object, int);                          /*
+typedef struct zip_Iterator zip_iterator;
+struct zip_Iterator {
+	int next, end;           /* range of the sorted filename index */
+	const char* pattern;     /* glob pattern, or NULL for a prefix */
+};
+
+void zip_find_prefix (zip_object, const char*, zip_iterator*);               /*
+      @param: prefix, e.g. "Pictures/"
+      @param: iterator to set up for zip_next()                               */
+
+void zip_find_glob (zip_object, const char*, zip_iterator*);                 /*
+      @param: pattern; '*' matches any characters including '/', '?' any
+              one character, and [a-z] or [!a-z] one of a set; a '[' with
+              no closing ']' matches itself
+      @param: iterator to set up for zip_next()                               */
+
+int zip_next (zip_object, zip_iterator*);                                     /*
+      return: local file number n of the next match in filename order, or
+              -1 when there are no more; appending files invalidates the
+              iterator. The first query sorts the filenames.                  */
+
+unsigned long long zip_get_file_length (zip_object, int);                     /*
       @param: n, the local file number.                                       */
 
-unsigned long zip_get_file (zip_object, int, unsigned char**);                /*
+unsigned long long zip_get_file (zip_object, int, unsigned char**);           /*
       @param: n, the local file number
       @param: destination ptr - destination will be malloc()ated
       return: size allocated                                                  */
 
-unsigned long zip_get_file_raw (zip_object, int, unsigned char**);            /*
+unsigned long long zip_get_file_raw (zip_object, int, unsigned char**);       /*
       @param: n, the local file number
       @param: dest ptr; dest will be allocated but caller must free
       return: size allocated                                                  */
 
+long long zip_get_file_into (zip_object, int, unsigned char*, unsigned long long);
+/*    @param: n, the local file number
+      @param: destination, owned by the caller and reusable between calls
+      @param: size of destination, at least zip_get_file_length()
+      return: size written, or -1 on failure; no memory is allocated per
+              call for files on memory mapped disks                           */
+
+const unsigned char* zip_get_file_cached (zip_object, int, unsigned long long*);
+/*    @param: n, the local file number
+      @param: set to the size of the file
+      return: its uncompressed data, read-only and shared, or NULL; once in
+              the cache, repeated calls only look it up. The buffer stays
+              valid, even if evicted, until zip_release_file().               */
+
+void zip_release_file (zip_object, const unsigned char*);                     /*
+      @param: buffer from zip_get_file_cached(); release each one once,
+              and all of them before zip_destructor()                         */
+
+typedef struct zip_Cache_Stats zip_cache_stats;
+struct zip_Cache_Stats {
+	unsigned long long hits, misses, evictions;
+	unsigned long long bytes;    /* extracted data held in the cache */
+	unsigned long entries;
+};
+
+void zip_get_cache_stats (zip_object, zip_cache_stats*);                      /*
+      @param: set to the counts since zip_constructor()                       */
+
+unsigned long long zip_view_file_raw (zip_object, int, const unsigned char**);
+/*    @param: n, the local file number
+      @param: view ptr, set to the compressed data in place; it is NULL
+              if the file is on a disk that is not memory mapped
+      return: size of the view; it stays valid until zip_destructor()       */
+
+typedef int (*zip_stream_sink) (const unsigned char*, unsigned long, void*);
+/*    @param: next block of uncompressed data, valid only until it returns
+      @param: size of the block
+      @param: context given to zip_extract_stream()
+      return: nonzero to stop the extraction                                  */
+
+long long zip_extract_stream (zip_object, int, zip_stream_sink, void*);       /*
+      @param: n, the local file number
+      @param: sink for the data, block by block, and its context
+      return: size extracted, or -1 on failure or if the sink stopped; a
+              file of any size takes a few hundred KiB of memory              */
+
+typedef int (*zip_extract_callback) (int, const unsigned char*, unsigned long long, void*);
+/*    @param: n, the local file number
+      @param: its uncompressed data, or NULL if it could not be extracted;
+              valid only until the callback returns
+      @param: size of the data
+      @param: context given to zip_extract_all() or zip_extract_set()
+      return: nonzero to stop handing out further files
+      It is called from the worker threads, several at once.                 */
+
+int zip_extract_all (zip_object, int, zip_extract_callback, void*);          /*
+      @param: number of worker threads, or 0 for one per online CPU
+      @param: callback for each file, and its context
+      return: number of files extracted                                       */
+
+int zip_extract_set (zip_object, const int*, int, int, zip_extract_callback, void*);
+/*    @param: local file numbers to extract, and how many there are
+      @param: number of worker threads, or 0 for one per online CPU
+      @param: callback for each file, and its context
+      return: number of files extracted; the largest files are started
+              first and idle workers steal files from the busy ones          */
+
+int zip_extract_pipelined (zip_object, const int*, int, zip_extract_callback, void*);
+/*    @param: local file numbers to extract, and how many there are
+      @param: callback for each file, and its context
+      return: number of files extracted; a second thread reads up to four
+              files ahead while this one inflates, and the callback runs
+              on this thread with the files in the order they are on disk     */
+
+int zip_extract_batch (zip_object, const int*, int, zip_extract_callback, void*);
+/*    @param: local file numbers to extract, and how many there are
+      @param: callback for each file, and its context
+      return: number of files extracted; all the reads are issued together,
+              through io_uring or else a few reading threads, and the
+              callback runs on this thread as each file's read completes     */
+
 void zip_remove_file (zip_object, int);                                       /*
       @param: n, the local file number                                        */
 
 #define ZIP_APPEND_NO_COMPRESSION 0
 #define ZIP_APPEND_DEFLATE_COMPRESSION 8
-void zip_append_file (zip_object, const unsigned char*, int, int);            /*
+int zip_append_file (zip_object, const char*, const unsigned char*, int, int);/*
+      @param: filename within the archive
       @param: raw data to be appended
       @param: size of raw data
-      @param: compression method                                              */
+      @param: compression method; deflated data that is no smaller than
+              the raw data is stored instead
+      return: local file number n of the new file, or -1                      */
+
+void zip_set_deflate_level (zip_object, int);                                 /*
+      @param: level for later appends, COMP_DEFLATE_STORED (0) to
+              COMP_DEFLATE_BEST (9); the default is COMP_DEFLATE_DEFAULT (6)  */
+
+#define ZIP_WRITE_SUCCESS 1
+#define ZIP_WRITE_FAILURE 0
+int zip_write_disk (zip_object, const char*);                                 /*
+      @param: filename to write every local file to as a single disk;
+              it must not be one of the disks opened by the object
+      return: ZIP_WRITE_SUCCESS, or ZIP_WRITE_FAILURE                         */
 
 int   zip_error_code (zip_object);
 char* zip_error_name (int, char*);